@@ -0,0 +1,238 @@
+#include "stdafx.h"
+#include "HexCodec.h"
+#include <wchar.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define HEXCODEC_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define HEXCODEC_AVX2
+#else
+#define HEXCODEC_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// The wide SIMD paths assume wchar_t is UTF-16, as it is on Windows
+#if WCHAR_MAX == 0xFFFF
+#define HEXCODEC_WIDE16
+#endif
+
+namespace
+{
+	const char rgchHexDigits[] = "0123456789ABCDEF";
+
+	template <typename TChar> void EncodeScalar(const BYTE* lpb, size_t cb, TChar* szOut)
+	{
+		for (size_t i = 0; i < cb; i++)
+		{
+			szOut[i * 2] = static_cast<TChar>(rgchHexDigits[lpb[i] >> 4]);
+			szOut[i * 2 + 1] = static_cast<TChar>(rgchHexDigits[lpb[i] & 0xF]);
+		}
+	}
+
+	struct HexCodecImpl
+	{
+		void (*pfnEncodeA)(const BYTE*, size_t, char*);
+		void (*pfnEncodeW)(const BYTE*, size_t, wchar_t*);
+	};
+
+	const HexCodecImpl codecScalar = { EncodeScalar<char>, EncodeScalar<wchar_t> };
+
+#ifdef HEXCODEC_X86
+	// Maps each nibble n in the vector to its hex digit: n + '0', plus 7 more for A-F
+	inline __m128i NibblesToHex(__m128i n)
+	{
+		auto alpha = _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '0' - 10));
+		return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), alpha);
+	}
+
+	// Encodes 16 bytes into 32 narrow characters, split across lo and hi
+	inline void Encode16SSE2(const BYTE* lpb, __m128i& lo, __m128i& hi)
+	{
+		auto in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lpb));
+		auto mask = _mm_set1_epi8(0x0F);
+		auto high = NibblesToHex(_mm_and_si128(_mm_srli_epi16(in, 4), mask));
+		auto low = NibblesToHex(_mm_and_si128(in, mask));
+		lo = _mm_unpacklo_epi8(high, low);
+		hi = _mm_unpackhi_epi8(high, low);
+	}
+
+	void EncodeSSE2A(const BYTE* lpb, size_t cb, char* szOut)
+	{
+		size_t i = 0;
+		for (; i + 16 <= cb; i += 16)
+		{
+			__m128i lo, hi;
+			Encode16SSE2(lpb + i, lo, hi);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(szOut + i * 2), lo);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(szOut + i * 2 + 16), hi);
+		}
+
+		EncodeScalar(lpb + i, cb - i, szOut + i * 2);
+	}
+
+#ifdef HEXCODEC_WIDE16
+	void EncodeSSE2W(const BYTE* lpb, size_t cb, wchar_t* szOut)
+	{
+		auto zero = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 16 <= cb; i += 16)
+		{
+			__m128i lo, hi;
+			Encode16SSE2(lpb + i, lo, hi);
+			auto out = reinterpret_cast<__m128i*>(szOut + i * 2);
+			_mm_storeu_si128(out, _mm_unpacklo_epi8(lo, zero));
+			_mm_storeu_si128(out + 1, _mm_unpackhi_epi8(lo, zero));
+			_mm_storeu_si128(out + 2, _mm_unpacklo_epi8(hi, zero));
+			_mm_storeu_si128(out + 3, _mm_unpackhi_epi8(hi, zero));
+		}
+
+		EncodeScalar(lpb + i, cb - i, szOut + i * 2);
+	}
+
+#else
+	void EncodeSSE2W(const BYTE* lpb, size_t cb, wchar_t* szOut) { EncodeScalar(lpb, cb, szOut); }
+#endif
+
+	const HexCodecImpl codecSSE2 = { EncodeSSE2A, EncodeSSE2W };
+
+	HEXCODEC_AVX2 inline __m256i NibblesToHexAVX2(__m256i n)
+	{
+		auto alpha = _mm256_and_si256(_mm256_cmpgt_epi8(n, _mm256_set1_epi8(9)), _mm256_set1_epi8('A' - '0' - 10));
+		return _mm256_add_epi8(_mm256_add_epi8(n, _mm256_set1_epi8('0')), alpha);
+	}
+
+	// Encodes 32 bytes into 64 narrow characters, split across lo and hi
+	HEXCODEC_AVX2 inline void Encode32AVX2(const BYTE* lpb, __m256i& lo, __m256i& hi)
+	{
+		auto in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lpb));
+		auto mask = _mm256_set1_epi8(0x0F);
+		auto high = NibblesToHexAVX2(_mm256_and_si256(_mm256_srli_epi16(in, 4), mask));
+		auto low = NibblesToHexAVX2(_mm256_and_si256(in, mask));
+
+		// Unpacking works within each 128 bit lane, so put the lanes back in order
+		auto unpackLo = _mm256_unpacklo_epi8(high, low);
+		auto unpackHi = _mm256_unpackhi_epi8(high, low);
+		lo = _mm256_permute2x128_si256(unpackLo, unpackHi, 0x20);
+		hi = _mm256_permute2x128_si256(unpackLo, unpackHi, 0x31);
+	}
+
+	HEXCODEC_AVX2 void EncodeAVX2A(const BYTE* lpb, size_t cb, char* szOut)
+	{
+		size_t i = 0;
+		for (; i + 32 <= cb; i += 32)
+		{
+			__m256i lo, hi;
+			Encode32AVX2(lpb + i, lo, hi);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(szOut + i * 2), lo);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(szOut + i * 2 + 32), hi);
+		}
+
+		EncodeSSE2A(lpb + i, cb - i, szOut + i * 2);
+	}
+
+#ifdef HEXCODEC_WIDE16
+	HEXCODEC_AVX2 void EncodeAVX2W(const BYTE* lpb, size_t cb, wchar_t* szOut)
+	{
+		size_t i = 0;
+		for (; i + 32 <= cb; i += 32)
+		{
+			__m256i lo, hi;
+			Encode32AVX2(lpb + i, lo, hi);
+			auto out = reinterpret_cast<__m256i*>(szOut + i * 2);
+			_mm256_storeu_si256(out, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(lo)));
+			_mm256_storeu_si256(out + 1, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(lo, 1)));
+			_mm256_storeu_si256(out + 2, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(hi)));
+			_mm256_storeu_si256(out + 3, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(hi, 1)));
+		}
+
+		EncodeSSE2W(lpb + i, cb - i, szOut + i * 2);
+	}
+
+#else
+	void EncodeAVX2W(const BYTE* lpb, size_t cb, wchar_t* szOut) { EncodeScalar(lpb, cb, szOut); }
+#endif
+
+	const HexCodecImpl codecAVX2 = { EncodeAVX2A, EncodeAVX2W };
+
+	bool CpuHasSSE2()
+	{
+#if defined(_M_X64) || defined(__x86_64__)
+		return true;
+#elif defined(_MSC_VER)
+		int info[4] = {};
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+#else
+		return __builtin_cpu_supports("sse2") != 0;
+#endif
+	}
+
+	bool CpuHasAVX2()
+	{
+#if defined(_MSC_VER)
+		int info[4] = {};
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+
+		// AVX2 needs both the instructions and the OS saving the YMM registers
+		__cpuid(info, 1);
+		const int osxsaveAndAvx = (1 << 27) | (1 << 28);
+		if ((info[2] & osxsaveAndAvx) != osxsaveAndAvx) return false;
+		if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+#endif
+
+	const HexCodecImpl& GetHexCodec()
+	{
+		static const HexCodecImpl& codec =
+#ifdef HEXCODEC_X86
+			CpuHasAVX2() ? codecAVX2 : CpuHasSSE2() ? codecSSE2 :
+#endif
+			codecScalar;
+		return codec;
+	}
+
+	// Number of characters needed to encode cb bytes
+	inline size_t HexEncodedLength(size_t cb) { return cb * 2; }
+
+	// Encodes cb bytes from lpb into szOut, which must have room for HexEncodedLength(cb)
+	// characters. No null terminator is written.
+	void HexEncode(_In_reads_bytes_(cb) const BYTE* lpb, size_t cb, _Out_writes_(cb * 2) char* szOut)
+	{
+		GetHexCodec().pfnEncodeA(lpb, cb, szOut);
+	}
+
+	void HexEncode(_In_reads_bytes_(cb) const BYTE* lpb, size_t cb, _Out_writes_(cb * 2) wchar_t* szOut)
+	{
+		GetHexCodec().pfnEncodeW(lpb, cb, szOut);
+	}
+}
+
+std::wstring BinToHexString(_In_opt_ const SBinary* lpBin)
+{
+	if (!lpBin) return L"";
+	if (!lpBin->cb || !lpBin->lpb) return L"NULL";
+
+	std::wstring lpsz(HexEncodedLength(lpBin->cb), L'\0');
+	HexEncode(lpBin->lpb, lpBin->cb, &lpsz[0]);
+	return lpsz;
+}
+
+std::string BinToHexStringA(_In_opt_ const SBinary* lpBin)
+{
+	if (!lpBin) return "";
+	if (!lpBin->cb || !lpBin->lpb) return "NULL";
+
+	std::string lpsz(HexEncodedLength(lpBin->cb), '\0');
+	HexEncode(lpBin->lpb, lpBin->cb, &lpsz[0]);
+	return lpsz;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <MAPIDefS.h>
+#include <string>
+
+// Hex encoding for binary property data.
+// The codec picks an AVX2, SSE2 or scalar implementation once, based on the CPU
+// it runs on. Encoding always emits upper case.
+
+std::wstring BinToHexString(_In_opt_ const SBinary* lpBin);
+std::string BinToHexStringA(_In_opt_ const SBinary* lpBin);
+
@@ -0,0 +1,1403 @@
+#include "stdafx.h"
+#include "InMemoryMapi.h"
+#include "MapiArena.h"
+#include <MAPIUtil.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <wctype.h>
+#include "ProviderOrder.h"
+#include "StubUtils.h"
+
+/*
+ *  Allocation
+ *		Every block carries a header chaining the blocks allocated against it with
+ *		MAPIAllocateMore, so MAPIFreeBuffer on the parent releases them all. Inside a
+ *		MAPIArenaScope blocks come from the thread's arena instead, and are left for
+ *		the arena to take back. A chain is all one or the other: blocks allocated
+ *		against a parent come from wherever the parent did.
+ */
+struct AllocationHeader
+{
+	AllocationHeader* lpNext;
+	union
+	{
+		MAPIArena* lpArena; // The arena the block is in, or nullptr for the heap
+		ULONGLONG ullPad; // Keeps the caller's block 16 byte aligned on x64
+	};
+};
+
+static AllocationHeader* AllocateHeader(_In_opt_ MAPIArena* lpArena, ULONG cbSize)
+{
+	auto lpHeader = static_cast<AllocationHeader*>(lpArena ?
+		lpArena->Allocate(sizeof(AllocationHeader) + cbSize) :
+		malloc(sizeof(AllocationHeader) + cbSize));
+	if (!lpHeader) return nullptr;
+
+	lpHeader->ullPad = 0;
+	lpHeader->lpNext = nullptr;
+	lpHeader->lpArena = lpArena;
+	return lpHeader;
+}
+
+SCODE STDMETHODCALLTYPE InMemoryAllocateBuffer(ULONG cbSize, LPVOID FAR* lppBuffer)
+{
+	if (!lppBuffer) return MAPI_E_INVALID_PARAMETER;
+	*lppBuffer = nullptr;
+
+	auto lpHeader = AllocateHeader(GetThreadMAPIArena(), cbSize);
+	if (!lpHeader) return MAPI_E_NOT_ENOUGH_MEMORY;
+
+	*lppBuffer = lpHeader + 1;
+	return S_OK;
+}
+
+SCODE STDMETHODCALLTYPE InMemoryAllocateMore(ULONG cbSize, LPVOID lpObject, LPVOID FAR* lppBuffer)
+{
+	if (!lpObject || !lppBuffer) return MAPI_E_INVALID_PARAMETER;
+	*lppBuffer = nullptr;
+
+	// An arena belongs to one thread, and its blocks only live as long as the scope they were
+	// allocated under, so a parent from an arena this thread isn't using can't be added to
+	auto lpParent = static_cast<AllocationHeader*>(lpObject) - 1;
+	if (lpParent->lpArena && lpParent->lpArena != GetThreadMAPIArena()) return MAPI_E_INVALID_PARAMETER;
+
+	auto lpHeader = AllocateHeader(lpParent->lpArena, cbSize);
+	if (!lpHeader) return MAPI_E_NOT_ENOUGH_MEMORY;
+
+	lpHeader->lpNext = lpParent->lpNext;
+	lpParent->lpNext = lpHeader;
+	*lppBuffer = lpHeader + 1;
+	return S_OK;
+}
+
+ULONG STDAPICALLTYPE InMemoryFreeBuffer(LPVOID lpBuffer)
+{
+	if (!lpBuffer) return 0;
+
+	// The arena takes back a whole arena chain at once
+	auto lpHeader = static_cast<AllocationHeader*>(lpBuffer) - 1;
+	if (lpHeader->lpArena) return 0;
+
+	while (lpHeader)
+	{
+		auto lpNext = lpHeader->lpNext;
+		free(lpHeader);
+		lpHeader = lpNext;
+	}
+
+	return 0;
+}
+
+void STDAPICALLTYPE InMemoryFreeProws(LPSRowSet lpRows)
+{
+	if (!lpRows) return;
+
+	for (ULONG i = 0; i < lpRows->cRows; i++)
+	{
+		InMemoryFreeBuffer(lpRows->aRow[i].lpProps);
+	}
+
+	InMemoryFreeBuffer(lpRows);
+}
+
+// Copies cb bytes into a block chained to lpParent
+template <typename T> static HRESULT CopyMore(const void* lpSrc, size_t cb, LPVOID lpParent, T** lppDst)
+{
+	*lppDst = nullptr;
+	if (!cb) return S_OK;
+
+	LPVOID lpDst = nullptr;
+	auto hRes = InMemoryAllocateMore(static_cast<ULONG>(cb), lpParent, &lpDst);
+	if (FAILED(hRes)) return hRes;
+
+	memcpy(lpDst, lpSrc, cb);
+	*lppDst = static_cast<T*>(lpDst);
+	return S_OK;
+}
+
+/*
+ *  Properties
+ *		The store keeps its own copy of each value, covering the types found in
+ *		profile sections and in the profile, service and provider tables.
+ */
+struct StoredProp
+{
+	ULONG ulPropTag;
+	LONG l; // PT_LONG, PT_BOOLEAN
+	std::string szA;
+	std::wstring szW;
+	std::vector<BYTE> bin;
+	std::vector<std::vector<BYTE>> mvbin;
+};
+typedef std::vector<StoredProp> StoredProps;
+
+static StoredProp LongProp(ULONG ulPropTag, LONG l)
+{
+	StoredProp prop = {};
+	prop.ulPropTag = ulPropTag;
+	prop.l = l;
+	return prop;
+}
+
+static StoredProp StringProp(ULONG ulPropTag, const std::string& sz)
+{
+	StoredProp prop = {};
+	prop.ulPropTag = ulPropTag;
+	prop.szA = sz;
+	return prop;
+}
+
+static StoredProp BinaryProp(ULONG ulPropTag, const BYTE* lpb, size_t cb)
+{
+	StoredProp prop = {};
+	prop.ulPropTag = ulPropTag;
+	prop.bin.assign(lpb, lpb + cb);
+	return prop;
+}
+
+static StoredProp UIDProp(ULONG ulPropTag, const MAPIUID& uid)
+{
+	return BinaryProp(ulPropTag, uid.ab, sizeof(MAPIUID));
+}
+
+// Returns false if the value's type isn't one the store keeps
+static bool ToStoredProp(const SPropValue& prop, StoredProp& stored)
+{
+	stored = StoredProp();
+	stored.ulPropTag = prop.ulPropTag;
+
+	switch (PROP_TYPE(prop.ulPropTag))
+	{
+	case PT_LONG:
+		stored.l = prop.Value.l;
+		return true;
+	case PT_BOOLEAN:
+		stored.l = prop.Value.b;
+		return true;
+	case PT_STRING8:
+		if (!prop.Value.lpszA) return false;
+		stored.szA = prop.Value.lpszA;
+		return true;
+	case PT_UNICODE:
+		if (!prop.Value.lpszW) return false;
+		stored.szW = prop.Value.lpszW;
+		return true;
+	case PT_BINARY:
+		if (prop.Value.bin.cb && !prop.Value.bin.lpb) return false;
+		stored.bin.assign(prop.Value.bin.lpb, prop.Value.bin.lpb + prop.Value.bin.cb);
+		return true;
+	case PT_MV_BINARY:
+		if (prop.Value.MVbin.cValues && !prop.Value.MVbin.lpbin) return false;
+		for (ULONG i = 0; i < prop.Value.MVbin.cValues; i++)
+		{
+			const auto& bin = prop.Value.MVbin.lpbin[i];
+			if (bin.cb && !bin.lpb) return false;
+			stored.mvbin.emplace_back(bin.lpb, bin.lpb + bin.cb);
+		}
+
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Copies a stored value out to the caller. Strings and binaries are chained to lpParent.
+static HRESULT CopyStoredProp(const StoredProp& stored, SPropValue& prop, LPVOID lpParent)
+{
+	prop.ulPropTag = stored.ulPropTag;
+	prop.dwAlignPad = 0;
+
+	switch (PROP_TYPE(stored.ulPropTag))
+	{
+	case PT_LONG:
+		prop.Value.l = stored.l;
+		return S_OK;
+	case PT_BOOLEAN:
+		prop.Value.b = static_cast<unsigned short>(stored.l != 0);
+		return S_OK;
+	case PT_STRING8:
+		return CopyMore(stored.szA.c_str(), stored.szA.size() + 1, lpParent, &prop.Value.lpszA);
+	case PT_UNICODE:
+		return CopyMore(stored.szW.c_str(), (stored.szW.size() + 1) * sizeof(WCHAR), lpParent, &prop.Value.lpszW);
+	case PT_BINARY:
+		prop.Value.bin.cb = static_cast<ULONG>(stored.bin.size());
+		return CopyMore(stored.bin.data(), stored.bin.size(), lpParent, &prop.Value.bin.lpb);
+	case PT_MV_BINARY:
+	{
+		prop.Value.MVbin.cValues = 0;
+		prop.Value.MVbin.lpbin = nullptr;
+		if (stored.mvbin.empty()) return S_OK;
+
+		LPVOID lpBins = nullptr;
+		auto hRes = InMemoryAllocateMore(static_cast<ULONG>(stored.mvbin.size() * sizeof(SBinary)), lpParent, &lpBins);
+		if (FAILED(hRes)) return hRes;
+
+		prop.Value.MVbin.lpbin = static_cast<SBinary*>(lpBins);
+		for (const auto& bin : stored.mvbin)
+		{
+			auto& dst = prop.Value.MVbin.lpbin[prop.Value.MVbin.cValues];
+			dst.cb = static_cast<ULONG>(bin.size());
+			hRes = CopyMore(bin.data(), bin.size(), lpParent, &dst.lpb);
+			if (FAILED(hRes)) return hRes;
+			prop.Value.MVbin.cValues++;
+		}
+
+		return S_OK;
+	}
+	default:
+		return MAPI_E_BAD_VALUE;
+	}
+}
+
+static void SetErrorProp(SPropValue& prop, ULONG ulPropTag, SCODE sc)
+{
+	prop.ulPropTag = PROP_TAG(PT_ERROR, PROP_ID(ulPropTag));
+	prop.dwAlignPad = 0;
+	prop.Value.err = sc;
+}
+
+// PT_UNSPECIFIED matches any type with the same ID
+static const StoredProp* FindStoredProp(const StoredProps& props, ULONG ulPropTag)
+{
+	for (const auto& prop : props)
+	{
+		if (prop.ulPropTag == ulPropTag) return &prop;
+		if (PROP_TYPE(ulPropTag) == PT_UNSPECIFIED && PROP_ID(prop.ulPropTag) == PROP_ID(ulPropTag)) return &prop;
+	}
+
+	return nullptr;
+}
+
+// Table string comparisons are case insensitive, as they are in MAPI
+static bool IsSameStringA(const char* sz1, const char* sz2)
+{
+	for (; *sz1 && *sz2; sz1++, sz2++)
+	{
+		if (toupper(static_cast<unsigned char>(*sz1)) != toupper(static_cast<unsigned char>(*sz2))) return false;
+	}
+
+	return *sz1 == *sz2;
+}
+
+static bool IsSameStringW(const wchar_t* sz1, const wchar_t* sz2)
+{
+	for (; *sz1 && *sz2; sz1++, sz2++)
+	{
+		if (towupper(*sz1) != towupper(*sz2)) return false;
+	}
+
+	return *sz1 == *sz2;
+}
+
+static bool IsEqualToProp(const StoredProp& stored, const SPropValue& prop)
+{
+	if (PROP_TYPE(stored.ulPropTag) != PROP_TYPE(prop.ulPropTag)) return false;
+
+	switch (PROP_TYPE(stored.ulPropTag))
+	{
+	case PT_LONG:
+		return stored.l == prop.Value.l;
+	case PT_BOOLEAN:
+		return !stored.l == !prop.Value.b;
+	case PT_STRING8:
+		return prop.Value.lpszA && IsSameStringA(stored.szA.c_str(), prop.Value.lpszA);
+	case PT_UNICODE:
+		return prop.Value.lpszW && IsSameStringW(stored.szW.c_str(), prop.Value.lpszW);
+	case PT_BINARY:
+		return stored.bin.size() == prop.Value.bin.cb &&
+			(stored.bin.empty() || 0 == memcmp(stored.bin.data(), prop.Value.bin.lpb, stored.bin.size()));
+	default:
+		return false;
+	}
+}
+
+// Returns MAPI_E_TOO_COMPLEX for restrictions the store doesn't evaluate
+static HRESULT CheckRestriction(const SRestriction* lpRes)
+{
+	if (!lpRes) return MAPI_E_INVALID_PARAMETER;
+
+	switch (lpRes->rt)
+	{
+	case RES_AND:
+	case RES_OR:
+		for (ULONG i = 0; i < lpRes->res.resAnd.cRes; i++)
+		{
+			auto hRes = CheckRestriction(&lpRes->res.resAnd.lpRes[i]);
+			if (FAILED(hRes)) return hRes;
+		}
+
+		return S_OK;
+	case RES_NOT:
+		return CheckRestriction(lpRes->res.resNot.lpRes);
+	case RES_EXIST:
+		return S_OK;
+	case RES_PROPERTY:
+		if (!lpRes->res.resProperty.lpProp) return MAPI_E_INVALID_PARAMETER;
+		if (lpRes->res.resProperty.relop != RELOP_EQ && lpRes->res.resProperty.relop != RELOP_NE) return MAPI_E_TOO_COMPLEX;
+		return S_OK;
+	default:
+		return MAPI_E_TOO_COMPLEX;
+	}
+}
+
+// lpRes must have passed CheckRestriction
+static bool MatchRestriction(const StoredProps& row, const SRestriction& res)
+{
+	switch (res.rt)
+	{
+	case RES_AND:
+		for (ULONG i = 0; i < res.res.resAnd.cRes; i++)
+		{
+			if (!MatchRestriction(row, res.res.resAnd.lpRes[i])) return false;
+		}
+
+		return true;
+	case RES_OR:
+		for (ULONG i = 0; i < res.res.resOr.cRes; i++)
+		{
+			if (MatchRestriction(row, res.res.resOr.lpRes[i])) return true;
+		}
+
+		return false;
+	case RES_NOT:
+		return !MatchRestriction(row, *res.res.resNot.lpRes);
+	case RES_EXIST:
+		return FindStoredProp(row, res.res.resExist.ulPropTag) != nullptr;
+	case RES_PROPERTY:
+	{
+		// A row without the property matches neither RELOP_EQ nor RELOP_NE
+		auto lpStored = FindStoredProp(row, res.res.resProperty.ulPropTag);
+		if (!lpStored) return false;
+
+		auto fEqual = IsEqualToProp(*lpStored, *res.res.resProperty.lpProp);
+		return res.res.resProperty.relop == RELOP_EQ ? fEqual : !fEqual;
+	}
+	default:
+		return false;
+	}
+}
+
+/*
+ *  InMemoryTable
+ *		A snapshot table over a copy of the rows it was created with.
+ *		Supports columns, restrictions, seeking and QueryRows. Sorting, bookmarks,
+ *		categories and notifications are not supported.
+ */
+class InMemoryTable : public IMAPITable
+{
+public:
+	InMemoryTable(const std::vector<StoredProps>& rows, const std::vector<ULONG>& columns);
+
+	MAPI_IUNKNOWN_METHODS(IMPL)
+	MAPI_IMAPITABLE_METHODS(IMPL)
+
+private:
+	void ApplyRestriction(const SRestriction* lpRes);
+
+	std::atomic<ULONG> m_cRef;
+	std::vector<StoredProps> m_rows;
+	std::vector<ULONG> m_columns;
+	std::vector<size_t> m_view; // Indexes of the rows which pass the restriction
+	size_t m_iCursor;
+};
+
+InMemoryTable::InMemoryTable(const std::vector<StoredProps>& rows, const std::vector<ULONG>& columns)
+	: m_cRef(1), m_rows(rows), m_columns(columns), m_iCursor(0)
+{
+	ApplyRestriction(nullptr);
+}
+
+void InMemoryTable::ApplyRestriction(const SRestriction* lpRes)
+{
+	m_view.clear();
+	for (size_t i = 0; i < m_rows.size(); i++)
+	{
+		if (!lpRes || MatchRestriction(m_rows[i], *lpRes)) m_view.push_back(i);
+	}
+
+	m_iCursor = 0;
+}
+
+STDMETHODIMP InMemoryTable::QueryInterface(REFIID riid, LPVOID FAR* ppvObj)
+{
+	if (!ppvObj) return MAPI_E_INVALID_PARAMETER;
+	*ppvObj = nullptr;
+	if (!IsEqualIID(riid, IID_IUnknown) && !IsEqualIID(riid, IID_IMAPITable)) return MAPI_E_INTERFACE_NOT_SUPPORTED;
+
+	AddRef();
+	*ppvObj = static_cast<IMAPITable*>(this);
+	return S_OK;
+}
+
+STDMETHODIMP_(ULONG) InMemoryTable::AddRef()
+{
+	return ++m_cRef;
+}
+
+STDMETHODIMP_(ULONG) InMemoryTable::Release()
+{
+	auto cRef = --m_cRef;
+	if (!cRef) delete this;
+	return cRef;
+}
+
+STDMETHODIMP InMemoryTable::GetLastError(HRESULT, ULONG, LPMAPIERROR FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryTable::Advise(ULONG, LPMAPIADVISESINK, ULONG_PTR FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryTable::Unadvise(ULONG_PTR)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryTable::GetStatus(ULONG FAR* lpulTableStatus, ULONG FAR* lpulTableType)
+{
+	if (!lpulTableStatus || !lpulTableType) return MAPI_E_INVALID_PARAMETER;
+	*lpulTableStatus = TBLSTAT_COMPLETE;
+	*lpulTableType = TBLTYPE_SNAPSHOT;
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::SetColumns(LPSPropTagArray lpPropTagArray, ULONG)
+{
+	if (!lpPropTagArray || !lpPropTagArray->cValues) return MAPI_E_INVALID_PARAMETER;
+	m_columns.assign(lpPropTagArray->aulPropTag, lpPropTagArray->aulPropTag + lpPropTagArray->cValues);
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::QueryColumns(ULONG ulFlags, LPSPropTagArray FAR* lpPropTagArray)
+{
+	if (!lpPropTagArray) return MAPI_E_INVALID_PARAMETER;
+	*lpPropTagArray = nullptr;
+
+	auto columns = m_columns;
+	if (ulFlags & TBL_ALL_COLUMNS)
+	{
+		for (const auto& row : m_rows)
+		{
+			for (const auto& prop : row)
+			{
+				if (std::find(columns.begin(), columns.end(), prop.ulPropTag) == columns.end())
+				{
+					columns.push_back(prop.ulPropTag);
+				}
+			}
+		}
+	}
+
+	LPVOID lpBuffer = nullptr;
+	auto hRes = InMemoryAllocateBuffer(CbNewSPropTagArray(columns.size()), &lpBuffer);
+	if (FAILED(hRes)) return hRes;
+
+	auto lpTags = static_cast<LPSPropTagArray>(lpBuffer);
+	lpTags->cValues = static_cast<ULONG>(columns.size());
+	for (size_t i = 0; i < columns.size(); i++) lpTags->aulPropTag[i] = columns[i];
+	*lpPropTagArray = lpTags;
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::GetRowCount(ULONG, ULONG FAR* lpulCount)
+{
+	if (!lpulCount) return MAPI_E_INVALID_PARAMETER;
+	*lpulCount = static_cast<ULONG>(m_view.size());
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::SeekRow(BOOKMARK bkOrigin, LONG lRowCount, LONG FAR* lplRowsSought)
+{
+	LONG lOrigin = 0;
+	switch (bkOrigin)
+	{
+	case BOOKMARK_BEGINNING:
+		lOrigin = 0;
+		break;
+	case BOOKMARK_CURRENT:
+		lOrigin = static_cast<LONG>(m_iCursor);
+		break;
+	case BOOKMARK_END:
+		lOrigin = static_cast<LONG>(m_view.size());
+		break;
+	default:
+		return MAPI_E_INVALID_BOOKMARK;
+	}
+
+	auto lTarget = lOrigin + lRowCount;
+	if (lTarget < 0) lTarget = 0;
+	if (lTarget > static_cast<LONG>(m_view.size())) lTarget = static_cast<LONG>(m_view.size());
+
+	m_iCursor = lTarget;
+	if (lplRowsSought) *lplRowsSought = lTarget - lOrigin;
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::SeekRowApprox(ULONG ulNumerator, ULONG ulDenominator)
+{
+	if (!ulDenominator || ulNumerator > ulDenominator) return MAPI_E_INVALID_PARAMETER;
+	m_iCursor = static_cast<size_t>(static_cast<ULONGLONG>(m_view.size()) * ulNumerator / ulDenominator);
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::QueryPosition(ULONG FAR* lpulRow, ULONG FAR* lpulNumerator, ULONG FAR* lpulDenominator)
+{
+	if (!lpulRow || !lpulNumerator || !lpulDenominator) return MAPI_E_INVALID_PARAMETER;
+	*lpulRow = static_cast<ULONG>(m_iCursor);
+	*lpulNumerator = static_cast<ULONG>(m_iCursor);
+	*lpulDenominator = static_cast<ULONG>(m_view.size());
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::FindRow(LPSRestriction lpRestriction, BOOKMARK bkOrigin, ULONG ulFlags)
+{
+	auto hRes = CheckRestriction(lpRestriction);
+	if (FAILED(hRes)) return hRes;
+
+	hRes = SeekRow(bkOrigin, 0, nullptr);
+	if (FAILED(hRes)) return hRes;
+
+	if (ulFlags & DIR_BACKWARD)
+	{
+		for (auto i = m_iCursor; i > 0; i--)
+		{
+			if (MatchRestriction(m_rows[m_view[i - 1]], *lpRestriction))
+			{
+				m_iCursor = i - 1;
+				return S_OK;
+			}
+		}
+	}
+	else
+	{
+		for (auto i = m_iCursor; i < m_view.size(); i++)
+		{
+			if (MatchRestriction(m_rows[m_view[i]], *lpRestriction))
+			{
+				m_iCursor = i;
+				return S_OK;
+			}
+		}
+	}
+
+	return MAPI_E_NOT_FOUND;
+}
+
+STDMETHODIMP InMemoryTable::Restrict(LPSRestriction lpRestriction, ULONG)
+{
+	if (lpRestriction)
+	{
+		auto hRes = CheckRestriction(lpRestriction);
+		if (FAILED(hRes)) return hRes;
+	}
+
+	ApplyRestriction(lpRestriction);
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::CreateBookmark(BOOKMARK FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryTable::FreeBookmark(BOOKMARK)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryTable::SortTable(LPSSortOrderSet, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryTable::QuerySortOrder(LPSSortOrderSet FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryTable::QueryRows(LONG lRowCount, ULONG ulFlags, LPSRowSet FAR* lppRows)
+{
+	if (!lppRows) return MAPI_E_INVALID_PARAMETER;
+	*lppRows = nullptr;
+
+	// Reading backwards isn't supported
+	if (lRowCount < 0) return MAPI_E_NO_SUPPORT;
+
+	auto cRows = m_view.size() - m_iCursor;
+	if (static_cast<size_t>(lRowCount) < cRows) cRows = lRowCount;
+
+	LPVOID lpBuffer = nullptr;
+	auto hRes = InMemoryAllocateBuffer(static_cast<ULONG>(CbNewSRowSet(cRows)), &lpBuffer);
+	if (FAILED(hRes)) return hRes;
+
+	auto lpRows = static_cast<LPSRowSet>(lpBuffer);
+	lpRows->cRows = 0;
+	for (size_t i = 0; i < cRows && SUCCEEDED(hRes); i++)
+	{
+		const auto& row = m_rows[m_view[m_iCursor + i]];
+		auto& dst = lpRows->aRow[i];
+		dst.ulAdrEntryPad = 0;
+		dst.cValues = 0;
+		dst.lpProps = nullptr;
+
+		LPVOID lpProps = nullptr;
+		hRes = InMemoryAllocateBuffer(static_cast<ULONG>(m_columns.size() * sizeof(SPropValue)), &lpProps);
+		if (FAILED(hRes)) break;
+
+		dst.lpProps = static_cast<LPSPropValue>(lpProps);
+		lpRows->cRows++;
+		for (size_t iCol = 0; iCol < m_columns.size() && SUCCEEDED(hRes); iCol++)
+		{
+			auto lpStored = FindStoredProp(row, m_columns[iCol]);
+			if (lpStored)
+			{
+				hRes = CopyStoredProp(*lpStored, dst.lpProps[iCol], lpProps);
+			}
+			else
+			{
+				SetErrorProp(dst.lpProps[iCol], m_columns[iCol], MAPI_E_NOT_FOUND);
+			}
+
+			dst.cValues++;
+		}
+	}
+
+	if (FAILED(hRes))
+	{
+		InMemoryFreeProws(lpRows);
+		return hRes;
+	}
+
+	if (!(ulFlags & TBL_NOADVANCE)) m_iCursor += cRows;
+	*lppRows = lpRows;
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::Abort()
+{
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::ExpandRow(ULONG, LPBYTE, ULONG, ULONG, LPSRowSet FAR*, ULONG FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryTable::CollapseRow(ULONG, LPBYTE, ULONG, ULONG FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryTable::WaitForCompletion(ULONG, ULONG, ULONG FAR* lpulTableStatus)
+{
+	if (lpulTableStatus) *lpulTableStatus = TBLSTAT_COMPLETE;
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryTable::GetCollapseState(ULONG, ULONG, LPBYTE, ULONG FAR*, LPBYTE FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryTable::SetCollapseState(ULONG, ULONG, LPBYTE, BOOKMARK FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+/*
+ *  InMemorySection
+ *		A profile section. Writes go straight to the store, as they do for a real
+ *		profile section, so SaveChanges has nothing to do.
+ */
+class InMemorySection : public IProfSect
+{
+public:
+	InMemorySection(StoredProps& props, bool fModify);
+
+	MAPI_IUNKNOWN_METHODS(IMPL)
+	MAPI_IMAPIPROP_METHODS(IMPL)
+	MAPI_IPROFSECT_METHODS(IMPL)
+
+private:
+	std::atomic<ULONG> m_cRef;
+	StoredProps& m_props;
+	bool m_fModify;
+};
+
+InMemorySection::InMemorySection(StoredProps& props, bool fModify) : m_cRef(1), m_props(props), m_fModify(fModify)
+{
+}
+
+STDMETHODIMP InMemorySection::QueryInterface(REFIID riid, LPVOID FAR* ppvObj)
+{
+	if (!ppvObj) return MAPI_E_INVALID_PARAMETER;
+	*ppvObj = nullptr;
+	if (!IsEqualIID(riid, IID_IUnknown) && !IsEqualIID(riid, IID_IMAPIProp) && !IsEqualIID(riid, IID_IProfSect)) return MAPI_E_INTERFACE_NOT_SUPPORTED;
+
+	AddRef();
+	*ppvObj = static_cast<IProfSect*>(this);
+	return S_OK;
+}
+
+STDMETHODIMP_(ULONG) InMemorySection::AddRef()
+{
+	return ++m_cRef;
+}
+
+STDMETHODIMP_(ULONG) InMemorySection::Release()
+{
+	auto cRef = --m_cRef;
+	if (!cRef) delete this;
+	return cRef;
+}
+
+STDMETHODIMP InMemorySection::GetLastError(HRESULT, ULONG, LPMAPIERROR FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemorySection::SaveChanges(ULONG)
+{
+	return S_OK;
+}
+
+STDMETHODIMP InMemorySection::GetProps(LPSPropTagArray lpPropTagArray, ULONG, ULONG FAR* lpcValues, LPSPropValue FAR* lppPropArray)
+{
+	if (!lpcValues || !lppPropArray) return MAPI_E_INVALID_PARAMETER;
+	*lpcValues = 0;
+	*lppPropArray = nullptr;
+
+	// With no tag array, every property in the section is returned
+	std::vector<ULONG> tags;
+	if (lpPropTagArray)
+	{
+		tags.assign(lpPropTagArray->aulPropTag, lpPropTagArray->aulPropTag + lpPropTagArray->cValues);
+	}
+	else
+	{
+		for (const auto& prop : m_props) tags.push_back(prop.ulPropTag);
+	}
+
+	LPVOID lpBuffer = nullptr;
+	auto hRes = InMemoryAllocateBuffer(static_cast<ULONG>((tags.empty() ? 1 : tags.size()) * sizeof(SPropValue)), &lpBuffer);
+	if (FAILED(hRes)) return hRes;
+
+	auto lpProps = static_cast<LPSPropValue>(lpBuffer);
+	auto fErrors = false;
+	for (size_t i = 0; i < tags.size() && SUCCEEDED(hRes); i++)
+	{
+		auto lpStored = FindStoredProp(m_props, tags[i]);
+		if (lpStored)
+		{
+			hRes = CopyStoredProp(*lpStored, lpProps[i], lpBuffer);
+		}
+		else
+		{
+			SetErrorProp(lpProps[i], tags[i], MAPI_E_NOT_FOUND);
+			fErrors = true;
+		}
+	}
+
+	if (FAILED(hRes))
+	{
+		InMemoryFreeBuffer(lpBuffer);
+		return hRes;
+	}
+
+	*lpcValues = static_cast<ULONG>(tags.size());
+	*lppPropArray = lpProps;
+	return fErrors ? MAPI_W_ERRORS_RETURNED : S_OK;
+}
+
+STDMETHODIMP InMemorySection::GetPropList(ULONG, LPSPropTagArray FAR* lppPropTagArray)
+{
+	if (!lppPropTagArray) return MAPI_E_INVALID_PARAMETER;
+	*lppPropTagArray = nullptr;
+
+	LPVOID lpBuffer = nullptr;
+	auto hRes = InMemoryAllocateBuffer(CbNewSPropTagArray(m_props.size()), &lpBuffer);
+	if (FAILED(hRes)) return hRes;
+
+	auto lpTags = static_cast<LPSPropTagArray>(lpBuffer);
+	lpTags->cValues = static_cast<ULONG>(m_props.size());
+	for (size_t i = 0; i < m_props.size(); i++) lpTags->aulPropTag[i] = m_props[i].ulPropTag;
+	*lppPropTagArray = lpTags;
+	return S_OK;
+}
+
+STDMETHODIMP InMemorySection::OpenProperty(ULONG, LPCIID, ULONG, ULONG, LPUNKNOWN FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemorySection::SetProps(ULONG cValues, LPSPropValue lpPropArray, LPSPropProblemArray FAR* lppProblems)
+{
+	if (lppProblems) *lppProblems = nullptr;
+	if (!m_fModify) return MAPI_E_NO_ACCESS;
+	if (cValues && !lpPropArray) return MAPI_E_INVALID_PARAMETER;
+
+	// Convert everything first so a bad value leaves the section untouched
+	std::vector<StoredProp> values(cValues);
+	for (ULONG i = 0; i < cValues; i++)
+	{
+		if (!ToStoredProp(lpPropArray[i], values[i])) return MAPI_E_BAD_VALUE;
+	}
+
+	for (auto& value : values)
+	{
+		auto existing = std::find_if(m_props.begin(), m_props.end(),
+			[&](const StoredProp& prop) { return PROP_ID(prop.ulPropTag) == PROP_ID(value.ulPropTag); });
+		if (existing != m_props.end())
+		{
+			*existing = std::move(value);
+		}
+		else
+		{
+			m_props.push_back(std::move(value));
+		}
+	}
+
+	return S_OK;
+}
+
+STDMETHODIMP InMemorySection::DeleteProps(LPSPropTagArray lpPropTagArray, LPSPropProblemArray FAR* lppProblems)
+{
+	if (lppProblems) *lppProblems = nullptr;
+	if (!m_fModify) return MAPI_E_NO_ACCESS;
+	if (!lpPropTagArray) return MAPI_E_INVALID_PARAMETER;
+
+	for (ULONG i = 0; i < lpPropTagArray->cValues; i++)
+	{
+		auto ulPropId = PROP_ID(lpPropTagArray->aulPropTag[i]);
+		m_props.erase(
+			std::remove_if(m_props.begin(), m_props.end(), [&](const StoredProp& prop) { return PROP_ID(prop.ulPropTag) == ulPropId; }),
+			m_props.end());
+	}
+
+	return S_OK;
+}
+
+STDMETHODIMP InMemorySection::CopyTo(ULONG, LPCIID, LPSPropTagArray, ULONG_PTR, LPMAPIPROGRESS, LPCIID, LPVOID, ULONG, LPSPropProblemArray FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemorySection::CopyProps(LPSPropTagArray, ULONG_PTR, LPMAPIPROGRESS, LPCIID, LPVOID, ULONG, LPSPropProblemArray FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemorySection::GetNamesFromIDs(LPSPropTagArray FAR*, LPGUID, ULONG, ULONG FAR*, LPMAPINAMEID FAR* FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemorySection::GetIDsFromNames(ULONG, LPMAPINAMEID FAR*, ULONG, LPSPropTagArray FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+/*
+ *  Profile store
+ */
+struct MAPIUIDLess
+{
+	bool operator()(const MAPIUID& uid1, const MAPIUID& uid2) const
+	{
+		return memcmp(uid1.ab, uid2.ab, sizeof(MAPIUID)) < 0;
+	}
+};
+
+struct StoredProfile
+{
+	std::string name;
+	std::vector<StoredProps> services; // Rows of the message service table
+	std::vector<StoredProps> providers; // Rows of the provider table
+	std::map<MAPIUID, StoredProps, MAPIUIDLess> sections;
+};
+
+static std::vector<StoredProfile> g_storedProfiles;
+
+static const std::vector<ULONG> g_profileColumns = { PR_DISPLAY_NAME_A, PR_DEFAULT_PROFILE };
+static const std::vector<ULONG> g_serviceColumns = {
+	PR_INSTANCE_KEY, PR_SERVICE_UID, PR_RESOURCE_FLAGS, PR_DISPLAY_NAME_A, PR_SERVICE_NAME_A, PR_SERVICE_DLL_NAME_A };
+static const std::vector<ULONG> g_providerColumns = {
+	PR_INSTANCE_KEY, PR_PROVIDER_UID, PR_SERVICE_UID, PR_RESOURCE_TYPE, PR_PROVIDER_DISPLAY_A, PR_SERVICE_NAME_A };
+
+/*
+ *  InMemoryServiceAdmin
+ */
+class InMemoryServiceAdmin : public IMsgServiceAdmin
+{
+public:
+	explicit InMemoryServiceAdmin(StoredProfile& profile);
+
+	MAPI_IUNKNOWN_METHODS(IMPL)
+	MAPI_IMSGSERVICEADMIN_METHODS(IMPL)
+
+private:
+	std::atomic<ULONG> m_cRef;
+	StoredProfile& m_profile;
+};
+
+InMemoryServiceAdmin::InMemoryServiceAdmin(StoredProfile& profile) : m_cRef(1), m_profile(profile)
+{
+}
+
+STDMETHODIMP InMemoryServiceAdmin::QueryInterface(REFIID riid, LPVOID FAR* ppvObj)
+{
+	if (!ppvObj) return MAPI_E_INVALID_PARAMETER;
+	*ppvObj = nullptr;
+	if (!IsEqualIID(riid, IID_IUnknown) && !IsEqualIID(riid, IID_IMsgServiceAdmin)) return MAPI_E_INTERFACE_NOT_SUPPORTED;
+
+	AddRef();
+	*ppvObj = static_cast<IMsgServiceAdmin*>(this);
+	return S_OK;
+}
+
+STDMETHODIMP_(ULONG) InMemoryServiceAdmin::AddRef()
+{
+	return ++m_cRef;
+}
+
+STDMETHODIMP_(ULONG) InMemoryServiceAdmin::Release()
+{
+	auto cRef = --m_cRef;
+	if (!cRef) delete this;
+	return cRef;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::GetLastError(HRESULT, ULONG, LPMAPIERROR FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::GetMsgServiceTable(ULONG ulFlags, LPMAPITABLE FAR* lppTable)
+{
+	if (!lppTable) return MAPI_E_INVALID_PARAMETER;
+	*lppTable = nullptr;
+
+	// The store only keeps ANSI strings
+	if (ulFlags & MAPI_UNICODE) return MAPI_E_BAD_CHARWIDTH;
+
+	*lppTable = new InMemoryTable(m_profile.services, g_serviceColumns);
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::CreateMsgService(LPTSTR, LPTSTR, ULONG_PTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::DeleteMsgService(LPMAPIUID)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::CopyMsgService(LPMAPIUID, LPTSTR, LPCIID, LPCIID, LPVOID, ULONG_PTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::RenameMsgService(LPMAPIUID, ULONG, LPTSTR)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::ConfigureMsgService(LPMAPIUID, ULONG_PTR, ULONG, ULONG, LPSPropValue)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::OpenProfileSection(LPMAPIUID lpUID, LPCIID, ULONG ulFlags, LPPROFSECT FAR* lppProfSect)
+{
+	if (!lpUID || !lppProfSect) return MAPI_E_INVALID_PARAMETER;
+
+	// As in MAPI, opening a section which doesn't exist yet creates it empty
+	*lppProfSect = new InMemorySection(m_profile.sections[*lpUID], (ulFlags & MAPI_MODIFY) != 0);
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::MsgServiceTransportOrder(ULONG, LPMAPIUID, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::AdminProviders(LPMAPIUID, ULONG, LPPROVIDERADMIN FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::SetPrimaryIdentity(LPMAPIUID, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryServiceAdmin::GetProviderTable(ULONG ulFlags, LPMAPITABLE FAR* lppTable)
+{
+	if (!lppTable) return MAPI_E_INVALID_PARAMETER;
+	*lppTable = nullptr;
+	if (ulFlags & MAPI_UNICODE) return MAPI_E_BAD_CHARWIDTH;
+
+	*lppTable = new InMemoryTable(m_profile.providers, g_providerColumns);
+	return S_OK;
+}
+
+/*
+ *  InMemoryProfAdmin
+ */
+class InMemoryProfAdmin : public IProfAdmin
+{
+public:
+	InMemoryProfAdmin();
+
+	MAPI_IUNKNOWN_METHODS(IMPL)
+	MAPI_IPROFADMIN_METHODS(IMPL)
+
+private:
+	std::atomic<ULONG> m_cRef;
+};
+
+InMemoryProfAdmin::InMemoryProfAdmin() : m_cRef(1)
+{
+}
+
+STDMETHODIMP InMemoryProfAdmin::QueryInterface(REFIID riid, LPVOID FAR* ppvObj)
+{
+	if (!ppvObj) return MAPI_E_INVALID_PARAMETER;
+	*ppvObj = nullptr;
+	if (!IsEqualIID(riid, IID_IUnknown) && !IsEqualIID(riid, IID_IProfAdmin)) return MAPI_E_INTERFACE_NOT_SUPPORTED;
+
+	AddRef();
+	*ppvObj = static_cast<IProfAdmin*>(this);
+	return S_OK;
+}
+
+STDMETHODIMP_(ULONG) InMemoryProfAdmin::AddRef()
+{
+	return ++m_cRef;
+}
+
+STDMETHODIMP_(ULONG) InMemoryProfAdmin::Release()
+{
+	auto cRef = --m_cRef;
+	if (!cRef) delete this;
+	return cRef;
+}
+
+STDMETHODIMP InMemoryProfAdmin::GetLastError(HRESULT, ULONG, LPMAPIERROR FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryProfAdmin::GetProfileTable(ULONG ulFlags, LPMAPITABLE FAR* lppTable)
+{
+	if (!lppTable) return MAPI_E_INVALID_PARAMETER;
+	*lppTable = nullptr;
+	if (ulFlags & MAPI_UNICODE) return MAPI_E_BAD_CHARWIDTH;
+
+	std::vector<StoredProps> rows;
+	for (size_t i = 0; i < g_storedProfiles.size(); i++)
+	{
+		rows.push_back({ StringProp(PR_DISPLAY_NAME_A, g_storedProfiles[i].name), LongProp(PR_DEFAULT_PROFILE, i == 0) });
+	}
+
+	*lppTable = new InMemoryTable(rows, g_profileColumns);
+	return S_OK;
+}
+
+STDMETHODIMP InMemoryProfAdmin::CreateProfile(LPTSTR, LPTSTR, ULONG_PTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryProfAdmin::DeleteProfile(LPTSTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryProfAdmin::ChangeProfilePassword(LPTSTR, LPTSTR, LPTSTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryProfAdmin::CopyProfile(LPTSTR, LPTSTR, LPTSTR, ULONG_PTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryProfAdmin::RenameProfile(LPTSTR, LPTSTR, LPTSTR, ULONG_PTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryProfAdmin::SetDefaultProfile(LPTSTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP InMemoryProfAdmin::AdminServices(LPTSTR lpszProfileName, LPTSTR, ULONG_PTR, ULONG ulFlags, LPSERVICEADMIN FAR* lppServiceAdmin)
+{
+	if (!lpszProfileName || !lppServiceAdmin) return MAPI_E_INVALID_PARAMETER;
+	*lppServiceAdmin = nullptr;
+	if (ulFlags & MAPI_UNICODE) return MAPI_E_BAD_CHARWIDTH;
+
+	auto szProfileName = reinterpret_cast<LPCSTR>(lpszProfileName);
+	for (auto& profile : g_storedProfiles)
+	{
+		if (IsSameStringA(profile.name.c_str(), szProfileName))
+		{
+			*lppServiceAdmin = new InMemoryServiceAdmin(profile);
+			return S_OK;
+		}
+	}
+
+	return MAPI_E_NOT_FOUND;
+}
+
+/*
+ *  Exports
+ */
+static HRESULT STDAPICALLTYPE InMemoryInitialize(LPVOID)
+{
+	return S_OK;
+}
+
+static void STDAPICALLTYPE InMemoryUninitialize()
+{
+}
+
+static HRESULT STDMETHODCALLTYPE InMemoryAdminProfiles(ULONG, LPPROFADMIN FAR* lppProfAdmin)
+{
+	if (!lppProfAdmin) return MAPI_E_INVALID_PARAMETER;
+	*lppProfAdmin = new InMemoryProfAdmin();
+	return S_OK;
+}
+
+// HrQueryAllRows, written against IMAPITable so it works for any table
+static HRESULT STDAPICALLTYPE InMemoryQueryAllRows(
+	LPMAPITABLE lpTable,
+	LPSPropTagArray lpPropTags,
+	LPSRestriction lpRestriction,
+	LPSSortOrderSet lpSortOrderSet,
+	LONG crowsMax,
+	LPSRowSet FAR* lppRows)
+{
+	if (!lpTable || !lppRows) return MAPI_E_INVALID_PARAMETER;
+	*lppRows = nullptr;
+
+	auto hRes = S_OK;
+	if (lpPropTags) hRes = lpTable->SetColumns(lpPropTags, TBL_BATCH);
+	if (SUCCEEDED(hRes) && lpRestriction) hRes = lpTable->Restrict(lpRestriction, TBL_BATCH);
+	if (SUCCEEDED(hRes) && lpSortOrderSet) hRes = lpTable->SortTable(lpSortOrderSet, TBL_BATCH);
+	if (SUCCEEDED(hRes)) hRes = lpTable->SeekRow(BOOKMARK_BEGINNING, 0, nullptr);
+
+	ULONG cRows = 0;
+	if (SUCCEEDED(hRes)) hRes = lpTable->GetRowCount(0, &cRows);
+	if (SUCCEEDED(hRes) && crowsMax > 0 && cRows > static_cast<ULONG>(crowsMax)) hRes = MAPI_E_TABLE_TOO_BIG;
+	if (SUCCEEDED(hRes)) hRes = lpTable->QueryRows(cRows ? static_cast<LONG>(cRows) : 1, 0, lppRows);
+
+	return hRes;
+}
+
+static const MAPIExport g_inMemoryExports[] = {
+	{ "MAPIInitialize", reinterpret_cast<FARPROC>(static_cast<LPMAPIINITIALIZE>(InMemoryInitialize)) },
+	{ "MAPIUninitialize", reinterpret_cast<FARPROC>(static_cast<LPMAPIUNINITIALIZE>(InMemoryUninitialize)) },
+	{ "MAPIAdminProfiles", reinterpret_cast<FARPROC>(static_cast<LPMAPIADMINPROFILES>(InMemoryAdminProfiles)) },
+	{ "MAPIAllocateBuffer", reinterpret_cast<FARPROC>(static_cast<LPMAPIALLOCATEBUFFER>(InMemoryAllocateBuffer)) },
+	{ "MAPIAllocateMore", reinterpret_cast<FARPROC>(static_cast<LPMAPIALLOCATEMORE>(InMemoryAllocateMore)) },
+	{ "MAPIFreeBuffer", reinterpret_cast<FARPROC>(static_cast<LPMAPIFREEBUFFER>(InMemoryFreeBuffer)) },
+	{ "FreeProws", reinterpret_cast<FARPROC>(InMemoryFreeProws) },
+	{ "HrQueryAllRows", reinterpret_cast<FARPROC>(InMemoryQueryAllRows) },
+};
+
+void BindInMemoryMAPI()
+{
+	SetMAPIExports(g_inMemoryExports, _countof(g_inMemoryExports));
+}
+
+/*
+ *  Generator
+ */
+struct GeneratedService
+{
+	LPCSTR szService;
+	LPCSTR szDisplayName;
+	LPCSTR szDll;
+	bool fAddressBook; // Takes a share of the non contab address book providers
+};
+
+static const GeneratedService g_contabService = { "CONTAB", "Outlook Address Book", "contab32.dll", true };
+
+// Cycled through for every service other than contab
+static const GeneratedService g_otherServices[] = {
+	{ "MSEMS", "Microsoft Exchange", "emsmdb32.dll", true },
+	{ "MSUPST MS", "Personal Folders", "mspst32.dll", false },
+	{ "EMABLT", "LDAP Directory", "emablt32.dll", true },
+	{ "MSPST MS", "Personal Folders", "mspst32.dll", false },
+};
+
+// splitmix64, so a seed gives the same profiles on every platform
+static ULONGLONG NextRandom(ULONGLONG& ullState)
+{
+	auto z = (ullState += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static MAPIUID NewUID(ULONGLONG& ullState)
+{
+	MAPIUID uid = {};
+	auto ullLow = NextRandom(ullState);
+	auto ullHigh = NextRandom(ullState);
+	memcpy(uid.ab, &ullLow, sizeof(ullLow));
+	memcpy(uid.ab + sizeof(ullLow), &ullHigh, sizeof(ullHigh));
+	return uid;
+}
+
+// Index at which contab goes in a list of cOthers other entries
+static size_t ContabPosition(ContabOrder contabOrder, size_t cOthers, ULONGLONG& ullState)
+{
+	switch (contabOrder)
+	{
+	case ContabOrder::First:
+		return 0;
+	case ContabOrder::Shuffled:
+		return static_cast<size_t>(NextRandom(ullState) % (cOthers + 1));
+	default:
+		return cOthers;
+	}
+}
+
+struct GeneratedProvider
+{
+	MAPIUID uid;
+	size_t iService;
+};
+
+static StoredProfile GenerateProfile(ULONG iProfile, const GeneratedProfileOptions& options)
+{
+	auto ullState = (static_cast<ULONGLONG>(options.ulSeed) << 32) | iProfile;
+	auto cProviders = options.cProviders ? options.cProviders : 1;
+	auto cServices = options.cServices ? options.cServices : 1;
+	if (cProviders > 1 && cServices < 2) cServices = 2;
+
+	StoredProfile profile;
+	profile.name = "Profile " + std::to_string(iProfile + 1);
+
+	// Services, with contab slotted in among the others
+	std::vector<const GeneratedService*> kinds;
+	for (ULONG i = 0; i < cServices - 1; i++)
+	{
+		kinds.push_back(&g_otherServices[i % _countof(g_otherServices)]);
+	}
+
+	auto iContabService = ContabPosition(options.contabOrder, kinds.size(), ullState);
+	kinds.insert(kinds.begin() + iContabService, &g_contabService);
+
+	std::vector<MAPIUID> serviceUIDs;
+	for (const auto kind : kinds)
+	{
+		auto uid = NewUID(ullState);
+		serviceUIDs.push_back(uid);
+		profile.services.push_back({
+			UIDProp(PR_INSTANCE_KEY, uid),
+			UIDProp(PR_SERVICE_UID, uid),
+			LongProp(PR_RESOURCE_FLAGS, 0),
+			StringProp(PR_DISPLAY_NAME_A, kind->szDisplayName),
+			StringProp(PR_SERVICE_NAME_A, kind->szService),
+			StringProp(PR_SERVICE_DLL_NAME_A, kind->szDll) });
+		profile.sections[uid] = {
+			StringProp(PR_SERVICE_NAME_A, kind->szService),
+			StringProp(PR_DISPLAY_NAME_A, kind->szDisplayName),
+			UIDProp(PR_SERVICE_UID, uid) };
+	}
+
+	// Address book providers other than contab are dealt round robin to the address book services
+	std::vector<size_t> addressBookServices;
+	for (size_t i = 0; i < kinds.size(); i++)
+	{
+		if (i != iContabService && kinds[i]->fAddressBook) addressBookServices.push_back(i);
+	}
+
+	std::vector<GeneratedProvider> others;
+	for (ULONG i = 0; i < cProviders - 1; i++)
+	{
+		others.push_back({ NewUID(ullState), addressBookServices[i % addressBookServices.size()] });
+	}
+
+	GeneratedProvider contab = { NewUID(ullState), iContabService };
+
+	std::vector<GeneratedProvider> providers = others;
+	providers.push_back(contab);
+	for (const auto& provider : providers)
+	{
+		const auto kind = kinds[provider.iService];
+		const auto& serviceUID = serviceUIDs[provider.iService];
+		profile.providers.push_back({
+			UIDProp(PR_INSTANCE_KEY, provider.uid),
+			UIDProp(PR_PROVIDER_UID, provider.uid),
+			UIDProp(PR_SERVICE_UID, serviceUID),
+			LongProp(PR_RESOURCE_TYPE, MAPI_AB_PROVIDER),
+			StringProp(PR_PROVIDER_DISPLAY_A, kind->szDisplayName),
+			StringProp(PR_SERVICE_NAME_A, kind->szService) });
+		profile.sections[provider.uid] = {
+			UIDProp(PR_PROVIDER_UID, provider.uid),
+			UIDProp(PR_SERVICE_UID, serviceUID),
+			LongProp(PR_RESOURCE_TYPE, MAPI_AB_PROVIDER),
+			StringProp(PR_PROVIDER_DISPLAY_A, kind->szDisplayName) };
+
+		// Each service lists its own providers in its section
+		auto& serviceSection = profile.sections[serviceUID];
+		auto lpList = std::find_if(serviceSection.begin(), serviceSection.end(),
+			[](const StoredProp& prop) { return prop.ulPropTag == PR_AB_PROVIDERS; });
+		if (lpList == serviceSection.end())
+		{
+			serviceSection.push_back(UIDProp(PR_AB_PROVIDERS, provider.uid));
+		}
+		else
+		{
+			lpList->bin.insert(lpList->bin.end(), provider.uid.ab, provider.uid.ab + sizeof(MAPIUID));
+		}
+	}
+
+	// The profile wide load order
+	std::vector<BYTE> order;
+	auto iContabProvider = ContabPosition(options.contabOrder, others.size(), ullState);
+	for (size_t i = 0; i <= others.size(); i++)
+	{
+		if (i == iContabProvider && options.contabOrder != ContabOrder::Missing)
+		{
+			order.insert(order.end(), contab.uid.ab, contab.uid.ab + sizeof(MAPIUID));
+		}
+
+		if (i < others.size())
+		{
+			order.insert(order.end(), others[i].uid.ab, others[i].uid.ab + sizeof(MAPIUID));
+		}
+	}
+
+	profile.sections[muidProviderSection] = { BinaryProp(PR_AB_PROVIDERS, order.data(), order.size()) };
+
+	return profile;
+}
+
+void GenerateInMemoryProfiles(const GeneratedProfileOptions& options)
+{
+	g_storedProfiles.clear();
+	g_storedProfiles.reserve(options.cProfiles);
+	for (ULONG i = 0; i < options.cProfiles; i++)
+	{
+		g_storedProfiles.push_back(GenerateProfile(i, options));
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <MAPIX.h>
+
+// An in-process stand in for the parts of MAPI this tool uses: IProfAdmin,
+// IMsgServiceAdmin, IProfSect and IMAPITable, plus the allocators and table helpers.
+// Profiles live in a process wide store which is only ever filled by the generator
+// below, so a run against it is deterministic and needs no Outlook install.
+// The store is not thread safe, and must not be regenerated while objects opened
+// from it are still alive.
+
+// Where the contab provider lands in the generated PR_AB_PROVIDERS list
+enum class ContabOrder
+{
+	First, // Already fixed
+	Last, // Needs the full rotation
+	Shuffled, // Somewhere in the list, chosen from the seed
+	Missing, // Not in the list at all
+};
+
+struct GeneratedProfileOptions
+{
+	ULONG cProfiles;
+	ULONG cServices; // Message services per profile, including contab
+	ULONG cProviders; // Address book providers per profile, including contab
+	ContabOrder contabOrder;
+	ULONG ulSeed;
+};
+
+// Replaces the contents of the store with cProfiles profiles named "Profile 1" and up.
+// Each has a contab service and cServices - 1 others. The other address book providers
+// are spread across the other services, so cServices is raised to 2 if they need a home.
+void GenerateInMemoryProfiles(const GeneratedProfileOptions& options);
+
+// Binds the MAPI stubs to the in-memory store. Call before MAPIInitialize.
+void BindInMemoryMAPI();
+
+// The store's allocators, which other in-process stand ins for MAPI share. Blocks from
+// MAPIAllocateMore are freed with the block they were allocated against. Inside a
+// MAPIArenaScope they come from the thread's arena (see MapiArena.h).
+SCODE STDMETHODCALLTYPE InMemoryAllocateBuffer(ULONG cbSize, LPVOID FAR* lppBuffer);
+SCODE STDMETHODCALLTYPE InMemoryAllocateMore(ULONG cbSize, LPVOID lpObject, LPVOID FAR* lppBuffer);
+ULONG STDAPICALLTYPE InMemoryFreeBuffer(LPVOID lpBuffer);
+void STDAPICALLTYPE InMemoryFreeProws(LPSRowSet lpRows);
@@ -0,0 +1,81 @@
+#include "stdafx.h"
+#include "MapiArena.h"
+#include <malloc.h>
+
+// Big enough for a profile's tables and sections, so a run rarely needs more than one
+static const size_t cbArenaChunk = 64 * 1024;
+static const size_t cbArenaAlign = 16;
+
+static thread_local MAPIArena t_mapiArena;
+static thread_local MAPIArena* t_lpMAPIArena = nullptr;
+
+MAPIArena::~MAPIArena()
+{
+	for (const auto& chunk : m_chunks)
+	{
+		_aligned_free(chunk.lpb);
+	}
+}
+
+LPVOID MAPIArena::Allocate(size_t cb)
+{
+	cb = (cb + cbArenaAlign - 1) & ~(cbArenaAlign - 1);
+	if (!cb) cb = cbArenaAlign;
+
+	// Fill the current chunk, then move on to the ones kept from earlier scopes
+	while (m_iChunk < m_chunks.size())
+	{
+		if (m_chunks[m_iChunk].cb - m_cbUsed >= cb)
+		{
+			auto lpv = m_chunks[m_iChunk].lpb + m_cbUsed;
+			m_cbUsed += cb;
+			return lpv;
+		}
+
+		// A next chunk too small for the request is left where it is, for later scopes
+		if (m_iChunk + 1 >= m_chunks.size() || m_chunks[m_iChunk + 1].cb < cb) break;
+
+		m_iChunk++;
+		m_cbUsed = 0;
+	}
+
+	// Anything bigger than a chunk gets one of its own size
+	Chunk chunk = { nullptr, cb > cbArenaChunk ? cb : cbArenaChunk };
+	chunk.lpb = static_cast<BYTE*>(_aligned_malloc(chunk.cb, cbArenaAlign));
+	if (!chunk.lpb) return nullptr;
+
+	// The new chunk goes right after the current one, so a rewind past it keeps it in order
+	auto iChunk = m_chunks.empty() ? 0 : m_iChunk + (m_cbUsed ? 1 : 0);
+	if (iChunk > m_chunks.size()) iChunk = m_chunks.size();
+	m_chunks.insert(m_chunks.begin() + iChunk, chunk);
+	m_iChunk = iChunk;
+	m_cbUsed = cb;
+	return chunk.lpb;
+}
+
+MAPIArena::Mark MAPIArena::GetMark() const
+{
+	return Mark{ m_iChunk, m_cbUsed };
+}
+
+void MAPIArena::Rewind(const Mark& mark)
+{
+	m_iChunk = mark.iChunk;
+	m_cbUsed = mark.cbUsed;
+}
+
+MAPIArena* GetThreadMAPIArena()
+{
+	return t_lpMAPIArena;
+}
+
+MAPIArenaScope::MAPIArenaScope() : m_lpPrevious(t_lpMAPIArena), m_mark(t_mapiArena.GetMark())
+{
+	t_lpMAPIArena = &t_mapiArena;
+}
+
+MAPIArenaScope::~MAPIArenaScope()
+{
+	t_mapiArena.Rewind(m_mark);
+	t_lpMAPIArena = m_lpPrevious;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+
+// A bump allocator behind the in-memory allocators, so rows and property values handed out
+// while processing a profile come out of a few large chunks rather than one heap block each.
+// MAPIFreeBuffer on a block from an arena does nothing: the arena takes everything back at once
+// when the MAPIArenaScope it was allocated under ends, and keeps its chunks for the next scope.
+// Each thread has an arena of its own, so none of this needs a lock.
+class MAPIArena
+{
+public:
+	MAPIArena() = default;
+	~MAPIArena();
+	MAPIArena(const MAPIArena&) = delete;
+	MAPIArena& operator=(const MAPIArena&) = delete;
+
+	// cb bytes, 16 byte aligned. nullptr if a chunk couldn't be allocated.
+	LPVOID Allocate(size_t cb);
+
+	// Where the next allocation would go. Rewinding to a mark takes back everything allocated since.
+	struct Mark
+	{
+		size_t iChunk;
+		size_t cbUsed;
+	};
+	Mark GetMark() const;
+	void Rewind(const Mark& mark);
+
+private:
+	struct Chunk
+	{
+		BYTE* lpb;
+		size_t cb;
+	};
+
+	std::vector<Chunk> m_chunks;
+	size_t m_iChunk = 0; // The chunk being allocated from
+	size_t m_cbUsed = 0; // How much of it is allocated
+};
+
+// The arena the in-memory allocators use on this thread, or nullptr outside any MAPIArenaScope
+MAPIArena* GetThreadMAPIArena();
+
+// While one is alive, the in-memory allocators on this thread allocate from the thread's arena.
+// When it ends, everything allocated under it is taken back, so every block must have been freed,
+// or be no longer used, by then. Scopes nest.
+class MAPIArenaScope
+{
+public:
+	MAPIArenaScope();
+	~MAPIArenaScope();
+	MAPIArenaScope(const MAPIArenaScope&) = delete;
+	MAPIArenaScope& operator=(const MAPIArenaScope&) = delete;
+
+private:
+	MAPIArena* m_lpPrevious;
+	MAPIArena::Mark m_mark;
+};
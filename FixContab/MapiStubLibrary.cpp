@@ -12,6 +12,12 @@
 #include <abhelp.h>
 
 #include <strsafe.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <vector>
+#include "StubUtils.h"
 
 
 // Check that we have the Outlook 2010 MAPI headers or higher
@@ -47,1456 +53,441 @@ struct RTF_WCSRETINFO;
 #define LINKAGE_NO_EXTERN_C		/* */
 
 // Forward declares from MapiStubUtil.cpp
-HMODULE GetMAPIHandle();
-HMODULE GetPrivateMAPI();
-void UnLoadPrivateMAPI();
-extern volatile ULONG g_ulDllSequenceNum;
-
-
-#define DEFINE_STUB_FUNCTION_V0(_linkage, _modifiers, _name, _lookup)	\
-																\
-	_linkage typedef void (_modifiers * _name##TYPE)(void);		\
-																\
-	_linkage void _modifiers _name(void)						\
-	{															\
-		static _name##TYPE _name##VAR = NULL;					\
-		static UINT ulDllSequenceNum = 0;						\
-																\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)			\
-			|| (NULL == GetMAPIHandle()))						\
-		{														\
-			_name##VAR = (_name##TYPE)							\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);	\
-			ulDllSequenceNum = g_ulDllSequenceNum;				\
-		}														\
-																\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))	\
-		{														\
-			_name##VAR();										\
-		}														\
+extern std::atomic<ULONG> g_ulDllSequenceNum;
+
+// The stubs are generated from MapiStubList.inl in three passes. The first two give each export
+// a slot and record the name or ordinal it is looked up by. BindMAPIStubs resolves every slot in
+// one pass whenever MAPI is bound, so each stub is just a call through its slot. The third pass,
+// at the end of this file, defines the stubs themselves, each a one line call into MAPIStubThunk.
+
+#define DEFINE_STUB_FUNCTION(_linkage, _ret_type, _modifiers, _name, _lookup, ...)	STUB_ENTRY(_name, _lookup, _ret_type)
+#define DEFINE_STUB_FUNCTION_V(_linkage, _modifiers, _name, _lookup, ...)				STUB_ENTRY(_name, _lookup, void)
+
+#define STUB_ENTRY(_name, _lookup, _ret_type)	stub##_name,
+enum MAPIStubSlot
+{
+#include "MapiStubList.inl"
+	cMAPIStubs
+};
+#undef STUB_ENTRY
+
+#define STUB_ENTRY(_name, _lookup, _ret_type)	_lookup,
+static const LPCSTR g_rgszMAPIStubLookups[cMAPIStubs] = {
+#include "MapiStubList.inl"
+};
+#undef STUB_ENTRY
+
+#ifdef MAPISTUB_INSTRUMENT
+// HRESULT and LONG are the same type, so whether a stub's result is an HRESULT is decided by the
+// return type it's declared with. That may carry SAL, as in "_Check_return_ HRESULT".
+static bool IsHResultTypeName(_In_z_ LPCSTR szType)
+{
+	const char szHResult[] = "HRESULT";
+	auto cchType = strlen(szType);
+	auto cchHResult = _countof(szHResult) - 1;
+	return 0 == strcmp(szType, "SCODE") ||
+		(cchType >= cchHResult && 0 == strcmp(szType + cchType - cchHResult, szHResult));
+} // IsHResultTypeName
+
+struct MAPIStubInfo
+{
+	LPCSTR szName;
+	bool fHResult;
+};
+
+#define STUB_ENTRY(_name, _lookup, _ret_type)	{ #_name, IsHResultTypeName(#_ret_type) },
+static const MAPIStubInfo g_rgMAPIStubInfo[cMAPIStubs] = {
+#include "MapiStubList.inl"
+};
+#undef STUB_ENTRY
+#endif // MAPISTUB_INSTRUMENT
+
+#undef DEFINE_STUB_FUNCTION
+#undef DEFINE_STUB_FUNCTION_V
+
+// Everything the stubs need from one binding, published as a whole so a stub never pairs
+// one binding's handle or generation with another's function pointers
+struct MAPIStubSnapshot
+{
+	HMODULE hinstMAPI;
+	ULONG ulSequenceNum;
+	bool fBound;
+	FARPROC rgpfn[cMAPIStubs];
+	MAPIStubSnapshot* lpNextRetired;
+};
+
+static std::atomic<MAPIStubSnapshot*> g_lpMAPIStubs(NULL);
+
+// Replaced snapshots. A stub on another thread may still be reading one, so they're kept rather
+// than freed. The binding only changes a handful of times per process.
+static std::atomic<MAPIStubSnapshot*> g_lpRetiredMAPIStubs(NULL);
+
+static void RetireMAPIStubs(_In_ MAPIStubSnapshot* lpStubs)
+{
+	auto lpRetired = g_lpRetiredMAPIStubs.load(std::memory_order_relaxed);
+	do
+	{
+		lpStubs->lpNextRetired = lpRetired;
+	} while (!g_lpRetiredMAPIStubs.compare_exchange_weak(lpRetired, lpStubs, std::memory_order_release, std::memory_order_relaxed));
+} // RetireMAPIStubs
+
+ULONG BindMAPIStubs()
+{
+	// The generation is read before the binding, so if the binding changes while we resolve
+	// whoever changed it publishes a newer snapshot and ours is dropped
+	auto lpStubs = new (std::nothrow) MAPIStubSnapshot;
+	if (!lpStubs) return 0;
+
+	lpStubs->ulSequenceNum = g_ulDllSequenceNum.load(std::memory_order_acquire);
+	lpStubs->hinstMAPI = GetMAPIHandle();
+	lpStubs->fBound = IsMAPIBound();
+	lpStubs->lpNextRetired = NULL;
+
+	ULONG cResolved = 0;
+	for (ULONG i = 0; i < cMAPIStubs; i++)
+	{
+		lpStubs->rgpfn[i] = lpStubs->fBound ? ResolveMAPIExport(lpStubs->hinstMAPI, g_rgszMAPIStubLookups[i]) : NULL;
+		if (NULL != lpStubs->rgpfn[i]) cResolved++;
 	}
 
-
-#define DEFINE_STUB_FUNCTION_ORD_V0(_linkage, _modifiers, _name, _ordinal)	\
-																\
-	_linkage typedef void (_modifiers * _name##TYPE)(void);		\
-																\
-	_linkage void _modifiers _name(void)						\
-	{															\
-		static _name##TYPE _name##VAR = NULL;					\
-		static UINT ulDllSequenceNum = 0;						\
-																\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)			\
-			|| (NULL == GetMAPIHandle()))						\
-		{														\
-			_name##VAR = (_name##TYPE)							\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));	\
-			ulDllSequenceNum = g_ulDllSequenceNum;				\
-		}														\
-																\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))	\
-		{														\
-			_name##VAR();										\
-		}														\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_0(_linkage, _ret_type, _modifiers,	\
-		_name, _lookup, _default)								\
-																\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(void);\
-																\
-	_linkage _ret_type _modifiers _name(void)					\
-	{															\
-		static _name##TYPE _name##VAR = NULL;					\
-		static UINT ulDllSequenceNum = 0;						\
-																\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)			\
-			|| (NULL == GetMAPIHandle()))						\
-		{														\
-			_name##VAR = (_name##TYPE)							\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);	\
-			ulDllSequenceNum = g_ulDllSequenceNum;				\
-		}														\
-																\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))	\
-		{														\
-			return _name##VAR();								\
-		}														\
-		else													\
-		{														\
-			return _default;									\
-		}														\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_ORD_0(_linkage, _ret_type, _modifiers,		\
-		_name, _ordinal, _default)										\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(void);		\
-																		\
-	_linkage _ret_type _modifiers _name(void)							\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));	\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR();										\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_V1(_linkage, _modifiers,					\
-		_name, _lookup, _param1_type)									\
-																		\
-	_linkage typedef void (_modifiers * _name##TYPE)(_param1_type);		\
-																		\
-	_linkage void _modifiers _name(_param1_type a)						\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			_name##VAR(a);												\
-		}																\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_ORD_V1(_linkage, _modifiers,				\
-		_name, _ordinal, _param1_type)									\
-																		\
-	_linkage typedef void (_modifiers * _name##TYPE)(_param1_type);		\
-																		\
-	_linkage void _modifiers _name(_param1_type a)						\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));	\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			_name##VAR(a);												\
-		}																\
+	auto lpPrev = g_lpMAPIStubs.load(std::memory_order_acquire);
+	do
+	{
+		if (lpPrev && lpPrev->ulSequenceNum >= lpStubs->ulSequenceNum)
+		{
+			delete lpStubs;
+			return cResolved;
+		}
+	} while (!g_lpMAPIStubs.compare_exchange_weak(lpPrev, lpStubs, std::memory_order_acq_rel, std::memory_order_acquire));
+
+	if (lpPrev) RetireMAPIStubs(lpPrev);
+	return cResolved;
+} // BindMAPIStubs
+
+// MAPI is loaded by the first call into any stub, and a failed load is retried by the next
+// call, as each stub used to do on its own
+static FARPROC BindMAPIStub(MAPIStubSlot slot)
+{
+	if (!IsMAPIBound()) GetPrivateMAPI();
+
+	auto lpStubs = g_lpMAPIStubs.load(std::memory_order_acquire);
+	if (!lpStubs || lpStubs->ulSequenceNum != g_ulDllSequenceNum.load(std::memory_order_acquire))
+	{
+		(void)BindMAPIStubs();
+		lpStubs = g_lpMAPIStubs.load(std::memory_order_acquire);
 	}
 
-
-#define DEFINE_STUB_FUNCTION_1(_linkage, _ret_type,						\
-		_modifiers, _name, _lookup, _param1_type, _default)				\
-																		\
-	_linkage typedef _ret_type											\
-			(_modifiers * _name##TYPE)(_param1_type);					\
-																		\
-	_linkage _ret_type _modifiers _name(_param1_type a)					\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a);										\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
+	return lpStubs && lpStubs->fBound ? lpStubs->rgpfn[slot] : NULL;
+} // BindMAPIStub
+
+// Binding publishes the snapshot up front, so a stub is normally one acquire load and a call
+static inline FARPROC GetMAPIStub(MAPIStubSlot slot)
+{
+	auto lpStubs = g_lpMAPIStubs.load(std::memory_order_acquire);
+	if (lpStubs && lpStubs->fBound) return lpStubs->rgpfn[slot];
+
+	return BindMAPIStub(slot);
+} // GetMAPIStub
+
+#ifdef MAPISTUB_INSTRUMENT
+// Call counts, errors and latency for every stub. Each thread records into its own counters so
+// the stubs never contend, and a thread's counters are merged into the totals when it exits.
+// Only the owning thread writes its counters, so relaxed loads and stores are enough for
+// ReportMAPIStubStats to read them while the thread runs.
+
+// Bucket i counts calls that took fewer than 2^i performance counter ticks, and at least 2^(i-1)
+const ULONG cMAPIStubLatencyBuckets = 40;
+
+struct MAPIStubCounters
+{
+	std::atomic<ULONGLONG> cCalls;
+	std::atomic<ULONGLONG> cErrors;
+	std::atomic<ULONGLONG> ullTicks;
+	std::atomic<ULONGLONG> rgcLatency[cMAPIStubLatencyBuckets];
+};
+
+struct MAPIStubThreadCounters
+{
+	MAPIStubCounters rgStubs[cMAPIStubs];
+	MAPIStubThreadCounters* lpNext;
+};
+
+// Guards the list of running threads' counters and the totals of threads that have exited
+static SRWLOCK g_srwMAPIStubCounters = SRWLOCK_INIT;
+static MAPIStubThreadCounters* g_lpMAPIStubThreads = NULL;
+static MAPIStubCounters g_rgMAPIStubTotals[cMAPIStubs];
+
+static inline void AddToCounter(std::atomic<ULONGLONG>& counter, ULONGLONG ullValue)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + ullValue, std::memory_order_relaxed);
+} // AddToCounter
+
+static void AddCounters(_In_ const MAPIStubCounters* lpFrom, _Inout_ MAPIStubCounters* lpTo)
+{
+	for (ULONG i = 0; i < cMAPIStubs; i++)
+	{
+		AddToCounter(lpTo[i].cCalls, lpFrom[i].cCalls.load(std::memory_order_relaxed));
+		AddToCounter(lpTo[i].cErrors, lpFrom[i].cErrors.load(std::memory_order_relaxed));
+		AddToCounter(lpTo[i].ullTicks, lpFrom[i].ullTicks.load(std::memory_order_relaxed));
+		for (ULONG iBucket = 0; iBucket < cMAPIStubLatencyBuckets; iBucket++)
+		{
+			AddToCounter(lpTo[i].rgcLatency[iBucket], lpFrom[i].rgcLatency[iBucket].load(std::memory_order_relaxed));
+		}
 	}
-
-
-#define DEFINE_STUB_FUNCTION_ORD_1(_linkage, _ret_type,					\
-		_modifiers, _name, _ordinal, _param1_type, _default)			\
-																		\
-	_linkage typedef _ret_type											\
-			(_modifiers * _name##TYPE)(_param1_type);					\
-																		\
-	_linkage _ret_type _modifiers _name(_param1_type a)					\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));	\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a);										\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
+} // AddCounters
+
+class MAPIStubThreadSlot
+{
+public:
+	~MAPIStubThreadSlot()
+	{
+		if (!m_lpCounters) return;
+
+		AcquireSRWLockExclusive(&g_srwMAPIStubCounters);
+		auto lppThread = &g_lpMAPIStubThreads;
+		while (*lppThread != m_lpCounters) lppThread = &(*lppThread)->lpNext;
+		*lppThread = m_lpCounters->lpNext;
+		AddCounters(m_lpCounters->rgStubs, g_rgMAPIStubTotals);
+		ReleaseSRWLockExclusive(&g_srwMAPIStubCounters);
+
+		delete m_lpCounters;
 	}
 
-
-#define DEFINE_STUB_FUNCTION_V2(_linkage, _modifiers,					\
-		_name, _lookup, _param1_type, _param2_type)						\
-																		\
-	_linkage typedef void (_modifiers * _name##TYPE)(					\
-			_param1_type, _param2_type);								\
-																		\
-	_linkage void _modifiers _name(_param1_type a, _param2_type b)		\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			_name##VAR(a, b);											\
-		}																\
+	MAPIStubThreadCounters* Get()
+	{
+		if (!m_lpCounters)
+		{
+			// Value initialized, so every counter starts at zero
+			m_lpCounters = new (std::nothrow) MAPIStubThreadCounters();
+			if (m_lpCounters)
+			{
+				AcquireSRWLockExclusive(&g_srwMAPIStubCounters);
+				m_lpCounters->lpNext = g_lpMAPIStubThreads;
+				g_lpMAPIStubThreads = m_lpCounters;
+				ReleaseSRWLockExclusive(&g_srwMAPIStubCounters);
+			}
+		}
+
+		return m_lpCounters;
 	}
 
-
-#define DEFINE_STUB_FUNCTION_ORD_V2(_linkage, _modifiers,				\
-		_name, _ordinal, _param1_type, _param2_type)					\
-																		\
-	_linkage typedef void (_modifiers * _name##TYPE)(					\
-			_param1_type, _param2_type);								\
-																		\
-	_linkage void _modifiers _name(_param1_type a, _param2_type b)		\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));	\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			_name##VAR(a, b);											\
-		}																\
+private:
+	MAPIStubThreadCounters* m_lpCounters = NULL;
+};
+
+static thread_local MAPIStubThreadSlot t_mapiStubCounters;
+
+// Times one stub call and records it when it goes out of scope. A call is an error if MAPI
+// doesn't have the export, so the stub returned its default, or it returned a failed HRESULT.
+class MAPIStubProbe
+{
+public:
+	// Started before the stub looks up its export, so a first call's discovery and load are timed
+	explicit MAPIStubProbe(MAPIStubSlot slot) : m_slot(slot), m_fError(false)
+	{
+		QueryPerformanceCounter(&m_liStart);
 	}
 
-
-#define DEFINE_STUB_FUNCTION_2(_linkage, _ret_type, _modifiers,			\
-		_name, _lookup, _param1_type, _param2_type, _default)			\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type);								\
-																		\
-	_linkage _ret_type _modifiers _name(_param1_type a, _param2_type b)	\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b);									\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
+	void Bound(bool fBound)
+	{
+		if (!fBound) m_fError = true;
 	}
 
+	~MAPIStubProbe()
+	{
+		LARGE_INTEGER liEnd = {};
+		QueryPerformanceCounter(&liEnd);
 
-#define DEFINE_STUB_FUNCTION_ORD_2(_linkage, _ret_type, _modifiers,		\
-		_name, _ordinal, _param1_type, _param2_type, _default)			\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type);								\
-																		\
-	_linkage _ret_type _modifiers _name(_param1_type a, _param2_type b)	\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));	\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b);									\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
-	}
+		auto lpThread = t_mapiStubCounters.Get();
+		if (!lpThread) return;
 
+		auto& counters = lpThread->rgStubs[m_slot];
+		auto ullTicks = static_cast<ULONGLONG>(liEnd.QuadPart - m_liStart.QuadPart);
+		ULONG iBucket = 0;
+		for (auto ull = ullTicks; ull && iBucket < cMAPIStubLatencyBuckets - 1; ull >>= 1) iBucket++;
 
-#define DEFINE_STUB_FUNCTION_V3(_linkage, _modifiers,					\
-		_name, _lookup, _param1_type, _param2_type, _param3_type)		\
-																		\
-	_linkage typedef void (_modifiers * _name##TYPE)(					\
-			_param1_type, _param2_type, _param3_type);					\
-																		\
-	_linkage void _modifiers _name(										\
-			_param1_type a, _param2_type b, _param3_type c)				\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			_name##VAR(a, b, c);										\
-		}																\
+		AddToCounter(counters.cCalls, 1);
+		if (m_fError) AddToCounter(counters.cErrors, 1);
+		AddToCounter(counters.ullTicks, ullTicks);
+		AddToCounter(counters.rgcLatency[iBucket], 1);
 	}
 
-
-#define DEFINE_STUB_FUNCTION_ORD_V3(_linkage, _modifiers,				\
-		_name, _ordinal, _param1_type, _param2_type, _param3_type)		\
-																		\
-	_linkage typedef void (_modifiers * _name##TYPE)(					\
-			_param1_type, _param2_type, _param3_type);					\
-																		\
-	_linkage void _modifiers _name(										\
-			_param1_type a, _param2_type b, _param3_type c)				\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));	\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			_name##VAR(a, b, c);										\
-		}																\
+	template <typename T> T Result(T result)
+	{
+		return result;
 	}
 
-
-#define DEFINE_STUB_FUNCTION_3(_linkage, _ret_type, _modifiers,			\
-		_name, _lookup, _param1_type, _param2_type, _param3_type, _default)	\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type, _param3_type);					\
-																		\
-	_linkage _ret_type _modifiers _name(								\
-			_param1_type a, _param2_type b, _param3_type c)				\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b, c);									\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
+	HRESULT Result(HRESULT hr)
+	{
+		if (FAILED(hr) && g_rgMAPIStubInfo[m_slot].fHResult) m_fError = true;
+		return hr;
 	}
 
-
-#define DEFINE_STUB_FUNCTION_ORD_3(_linkage, _ret_type, _modifiers,		\
-		_name, _ordinal, _param1_type, _param2_type, _param3_type, _default)	\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type, _param3_type);					\
-																		\
-	_linkage _ret_type _modifiers _name(								\
-			_param1_type a, _param2_type b, _param3_type c)				\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));	\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b, c);									\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
+private:
+	MAPIStubSlot m_slot;
+	bool m_fError;
+	LARGE_INTEGER m_liStart;
+};
+
+#define STUB_PROBE(_slot)		MAPIStubProbe mapiStubProbe(_slot);
+#define STUB_BOUND(_var)		mapiStubProbe.Bound(NULL != _var);
+#define STUB_RESULT(_call)		mapiStubProbe.Result(_call)
+
+void ReportMAPIStubStats(_In_ FILE* file)
+{
+	// Value initialized, so every counter starts at zero
+	std::unique_ptr<MAPIStubCounters[]> lpTotals(new (std::nothrow) MAPIStubCounters[cMAPIStubs]());
+	if (!lpTotals) return;
+
+	AcquireSRWLockShared(&g_srwMAPIStubCounters);
+	AddCounters(g_rgMAPIStubTotals, lpTotals.get());
+	for (auto lpThread = g_lpMAPIStubThreads; lpThread; lpThread = lpThread->lpNext)
+	{
+		AddCounters(lpThread->rgStubs, lpTotals.get());
 	}
+	ReleaseSRWLockShared(&g_srwMAPIStubCounters);
 
+	LARGE_INTEGER liFrequency = {};
+	QueryPerformanceFrequency(&liFrequency);
+	auto dblMicrosecondsPerTick = 1000000.0 / static_cast<double>(liFrequency.QuadPart);
 
-#define DEFINE_STUB_FUNCTION_V4(_linkage,								\
-		_modifiers, _name, _lookup, _param1_type,						\
-		_param2_type, _param3_type, _param4_type)						\
-																		\
-	_linkage typedef void (_modifiers * _name##TYPE)(					\
-			_param1_type, _param2_type, _param3_type, _param4_type)		\
-																		\
-	_linkage void _modifiers _name(										\
-			_param1_type a, _param2_type b, _param3_type c, _param4_type d)	\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			_name##VAR(a, b, c, d);										\
-		}																\
+	// Where the time went comes first
+	std::vector<ULONG> slots;
+	for (ULONG i = 0; i < cMAPIStubs; i++)
+	{
+		if (lpTotals[i].cCalls.load(std::memory_order_relaxed)) slots.push_back(i);
 	}
 
-#define DEFINE_STUB_FUNCTION_4(_linkage,								\
-		_ret_type, _modifiers, _name, _lookup, _param1_type,			\
-		_param2_type, _param3_type, _param4_type, _default)				\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type, _param3_type, _param4_type);	\
-																		\
-	_linkage _ret_type _modifiers _name(								\
-			_param1_type a, _param2_type b, _param3_type c, _param4_type d)	\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b, c, d);								\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_ORD_4(_linkage,							\
-		_ret_type, _modifiers, _name, _ordinal, _param1_type,			\
-		_param2_type, _param3_type, _param4_type, _default)				\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type, _param3_type, _param4_type);	\
-																		\
-	_linkage _ret_type _modifiers _name(								\
-			_param1_type a, _param2_type b, _param3_type c, _param4_type d)	\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));	\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b, c, d);								\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
+	std::sort(slots.begin(), slots.end(), [&](ULONG i1, ULONG i2) {
+		return lpTotals[i1].ullTicks.load(std::memory_order_relaxed) > lpTotals[i2].ullTicks.load(std::memory_order_relaxed); });
+
+	fprintf(file, "MAPI stub calls, by total time:\n");
+	for (auto i : slots)
+	{
+		const auto& counters = lpTotals[i];
+		auto cCalls = counters.cCalls.load(std::memory_order_relaxed);
+		auto dblTotal = counters.ullTicks.load(std::memory_order_relaxed) * dblMicrosecondsPerTick;
+		fprintf(file, "%s: %llu calls, %llu errors, %.1f us total, %.1f us mean\n",
+			g_rgMAPIStubInfo[i].szName,
+			cCalls,
+			counters.cErrors.load(std::memory_order_relaxed),
+			dblTotal,
+			dblTotal / cCalls);
+
+		for (ULONG iBucket = 0; iBucket < cMAPIStubLatencyBuckets; iBucket++)
+		{
+			auto cBucket = counters.rgcLatency[iBucket].load(std::memory_order_relaxed);
+			if (!cBucket) continue;
+
+			fprintf(file, "\t< %.1f us: %llu\n", static_cast<double>(1ULL << iBucket) * dblMicrosecondsPerTick, cBucket);
+		}
 	}
-
-
-#define DEFINE_STUB_FUNCTION_5(_linkage,								\
-		_ret_type, _modifiers, _name, _lookup,							\
-		_param1_type, _param2_type, _param3_type,						\
-		_param4_type, _param5_type, _default)							\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type, _param3_type, _param4_type, _param5_type);	\
-																		\
-	_linkage _ret_type _modifiers _name(_param1_type a, _param2_type b,	\
-			_param3_type c, _param4_type d, _param5_type e)				\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b, c, d, e);							\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_ORD_5(_linkage,							\
-		_ret_type, _modifiers, _name, _ordinal,							\
-		_param1_type, _param2_type, _param3_type,						\
-		_param4_type, _param5_type, _default)							\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type, _param3_type, _param4_type, _param5_type);	\
-																		\
-	_linkage _ret_type _modifiers _name(_param1_type a, _param2_type b,	\
-			_param3_type c, _param4_type d, _param5_type e)				\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));	\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b, c, d, e);							\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_6(_linkage, _ret_type, _modifiers,			\
-		_name, _lookup, _param1_type, _param2_type,						\
-		_param3_type, _param4_type, _param5_type, _param6_type, _default)	\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type, _param3_type,					\
-			_param4_type, _param5_type, _param6_type);					\
-																		\
-	_linkage _ret_type _modifiers _name(_param1_type a, _param2_type b,	\
-			_param3_type c, _param4_type d, _param5_type e, _param6_type f)	\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b, c, d, e, f);						\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_V7(_linkage, _modifiers, _name,			\
-		_lookup, _param1_type, _param2_type, _param3_type, _param4_type,\
-		_param5_type, _param6_type, _param7_type)						\
-																		\
-	_linkage typedef void (_modifiers * _name##TYPE)(					\
-			_param1_type, _param2_type, _param3_type,					\
-			_param4_type, _param5_type, _param6_type, _param7_type);	\
-																		\
-	_linkage void _modifiers _name(_param1_type a,						\
-			_param2_type b, _param3_type c, _param4_type d,				\
-			_param5_type e, _param6_type f, _param7_type g)				\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			_name##VAR(a, b, c, d, e, f, g);							\
-		}																\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_7(_linkage, _ret_type, _modifiers,			\
-		_name, _lookup, _param1_type, _param2_type, _param3_type,		\
-		_param4_type, _param5_type, _param6_type, _param7_type, _default)	\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type, _param3_type, _param4_type,		\
-			_param5_type, _param6_type, _param7_type);					\
-																		\
-	_linkage _ret_type _modifiers _name(_param1_type a, _param2_type b,	\
-			_param3_type c, _param4_type d, _param5_type e,				\
-			_param6_type f, _param7_type g)								\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b, c, d, e, f, g);						\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_8(_linkage, _ret_type, _modifiers,			\
-		_name, _lookup, _param1_type, _param2_type, _param3_type,		\
-		_param4_type, _param5_type, _param6_type, _param7_type, _param8_type, _default)	\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type, _param3_type, _param4_type,		\
-			_param5_type, _param6_type, _param7_type, _param8_type);	\
-																		\
-	_linkage _ret_type _modifiers _name(_param1_type a,					\
-			_param2_type b, _param3_type c, _param4_type d, _param5_type e,	\
-			_param6_type f, _param7_type g, _param8_type h)				\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b, c, d, e, f, g, h);					\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_9(_linkage, _ret_type,						\
-		_modifiers, _name, _lookup, _param1_type, _param2_type,			\
-		_param3_type, _param4_type, _param5_type, _param6_type,			\
-		_param7_type, _param8_type, _param9_type, _default)				\
-																		\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(				\
-			_param1_type, _param2_type, _param3_type,					\
-			_param4_type, _param5_type, _param6_type,					\
-			_param7_type, _param8_type, _param9_type);					\
-																		\
-	_linkage _ret_type _modifiers _name(_param1_type a, _param2_type b,	\
-			_param3_type c, _param4_type d, _param5_type e,				\
-			_param6_type f, _param7_type g, _param8_type h, _param9_type i)	\
-	{																	\
-		static _name##TYPE _name##VAR = NULL;							\
-		static UINT ulDllSequenceNum = 0;								\
-																		\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)					\
-			|| (NULL == GetMAPIHandle()))								\
-		{																\
-			_name##VAR = (_name##TYPE)									\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);			\
-			ulDllSequenceNum = g_ulDllSequenceNum;						\
-		}																\
-																		\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))			\
-		{																\
-			return _name##VAR(a, b, c, d, e, f, g, h, i);				\
-		}																\
-		else															\
-		{																\
-			return _default;											\
-		}																\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_10(_linkage, _ret_type, _modifiers,			\
-		_name, _lookup, _param1_type, _param2_type, _param3_type,			\
-		_param4_type, _param5_type, _param6_type, _param7_type,				\
-		_param8_type, _param9_type, _param10_type, _default)				\
-																			\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(					\
-			_param1_type, _param2_type, _param3_type,						\
-			_param4_type, _param5_type, _param6_type,						\
-			_param7_type, _param8_type, _param9_type, _param10_type);		\
-																			\
-	_linkage _ret_type _modifiers _name(_param1_type a, _param2_type b,		\
-			_param3_type c, _param4_type d, _param5_type e, _param6_type f,	\
-			_param7_type g, _param8_type h, _param9_type i, _param10_type j)		\
-	{																		\
-		static _name##TYPE _name##VAR = NULL;								\
-		static UINT ulDllSequenceNum = 0;									\
-																			\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)						\
-			|| (NULL == GetMAPIHandle()))									\
-		{																	\
-			_name##VAR = (_name##TYPE)										\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);				\
-			ulDllSequenceNum = g_ulDllSequenceNum;							\
-		}																	\
-																			\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))				\
-		{																	\
-			return _name##VAR(a, b, c, d, e, f, g, h, i, j);				\
-		}																	\
-		else																\
-		{																	\
-			return _default;												\
-		}																	\
-	}
-
-
-#define DEFINE_STUB_FUNCTION_11(_linkage, _ret_type, _modifiers,				\
-		_name, _lookup, _param1_type, _param2_type, _param3_type,				\
-		_param4_type, _param5_type, _param6_type, _param7_type, _param8_type,	\
-		_param9_type, _param10_type, _param11Type, _default)					\
-																				\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(						\
-			_param1_type, _param2_type, _param3_type, _param4_type,				\
-			_param5_type, _param6_type, _param7_type, _param8_type,				\
-			_param9_type, _param10_type, _param11Type);							\
-																				\
-	_linkage _ret_type _modifiers _name(_param1_type a,							\
-			_param2_type b, _param3_type c, _param4_type d,						\
-			_param5_type e, _param6_type f, _param7_type g,						\
-			_param8_type h, _param9_type i, _param10_type j, _param11Type k)	\
-	{																			\
-		static _name##TYPE _name##VAR = NULL;									\
-		static UINT ulDllSequenceNum = 0;										\
-																				\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)							\
-			|| (NULL == GetMAPIHandle()))										\
-		{																		\
-			_name##VAR = (_name##TYPE)											\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);					\
-			ulDllSequenceNum = g_ulDllSequenceNum;								\
-		}																		\
-																				\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))					\
-		{																		\
-			return _name##VAR(a, b, c, d, e, f, g, h, i, j, k);					\
-		}																		\
-		else																	\
-		{																		\
-			return _default;													\
-		}																		\
+} // ReportMAPIStubStats
+#else
+#define STUB_PROBE(_slot)
+#define STUB_BOUND(_var)
+#define STUB_RESULT(_call)		_call
+
+void ReportMAPIStubStats(_In_ FILE* file)
+{
+	fprintf(file, "MAPI stub calls aren't recorded. Build with MAPISTUB_INSTRUMENT defined to record them.\n");
+} // ReportMAPIStubStats
+#endif // MAPISTUB_INSTRUMENT
+
+
+// The one body every stub shares. Which export to call is the slot passed in rather than part
+// of the type, so stubs with the same signature share an instantiation. Every export MAPI has is
+// __stdcall, which WINAPI, PASCAL and STDMETHODCALLTYPE all are too.
+template <typename Fn> struct MAPIStubThunk;
+
+template <typename R, typename... Args> struct MAPIStubThunk<R (STDAPICALLTYPE *)(Args...)>
+{
+	static R Call(MAPIStubSlot slot, R defaultResult, Args... args)
+	{
+		STUB_PROBE(slot)
+		auto lpfn = reinterpret_cast<R (STDAPICALLTYPE *)(Args...)>(GetMAPIStub(slot));
+		STUB_BOUND(lpfn)
+
+		if (NULL != lpfn)
+		{
+			return STUB_RESULT(lpfn(args...));
+		}
+
+		return defaultResult;
 	}
-
-#define DEFINE_STUB_FUNCTION_12(_linkage, _ret_type, _modifiers,				\
-		_name, _lookup, _param1_type, _param2_type, _param3_type,				\
-		_param4_type, _param5_type, _param6_type, _param7_type, _param8_type,	\
-		_param9_type, _param10_type, _param11Type, _param12Type, _default)		\
-																				\
-	_linkage typedef _ret_type (_modifiers * _name##TYPE)(						\
-			_param1_type, _param2_type, _param3_type, _param4_type,				\
-			_param5_type, _param6_type, _param7_type, _param8_type,				\
-			_param9_type, _param10_type, _param11Type, _param12Type);			\
-																				\
-	_linkage _ret_type _modifiers _name(_param1_type a,							\
-			_param2_type b, _param3_type c, _param4_type d,						\
-			_param5_type e, _param6_type f, _param7_type g,						\
-			_param8_type h, _param9_type i, _param10_type j, _param11Type k, 	\
-			_param12Type l)														\
-	{																			\
-		static _name##TYPE _name##VAR = NULL;									\
-		static UINT ulDllSequenceNum = 0;										\
-																				\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)							\
-			|| (NULL == GetMAPIHandle()))										\
-		{																		\
-			_name##VAR = (_name##TYPE)											\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);					\
-			ulDllSequenceNum = g_ulDllSequenceNum;								\
-		}																		\
-																				\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))					\
-		{																		\
-			return _name##VAR(a, b, c, d, e, f, g, h, i, j, k, l);				\
-		}																		\
-		else																	\
-		{																		\
-			return _default;													\
-		}																		\
+};
+
+template <typename... Args> struct MAPIStubThunk<void (STDAPICALLTYPE *)(Args...)>
+{
+	static void Call(MAPIStubSlot slot, Args... args)
+	{
+		STUB_PROBE(slot)
+		auto lpfn = reinterpret_cast<void (STDAPICALLTYPE *)(Args...)>(GetMAPIStub(slot));
+		STUB_BOUND(lpfn)
+
+		if (NULL != lpfn)
+		{
+			lpfn(args...);
+		}
 	}
-
-
-#define DEFINE_STUB_FUNCTION_V12(_linkage, _modifiers,							\
-		_name, _lookup, _param1_type, _param2_type, _param3_type,				\
-		_param4_type, _param5_type, _param6_type, _param7_type, _param8_type,	\
-		_param9_type, _param10_type, _param11Type, _param12Type)				\
-																				\
-	_linkage typedef void (_modifiers * _name##TYPE)(							\
-			_param1_type, _param2_type, _param3_type, _param4_type,				\
-			_param5_type, _param6_type, _param7_type, _param8_type,				\
-			_param9_type, _param10_type, _param11Type, _param12Type);			\
-																				\
-	_linkage void _modifiers _name(_param1_type a,								\
-			_param2_type b, _param3_type c, _param4_type d,						\
-			_param5_type e, _param6_type f, _param7_type g,						\
-			_param8_type h, _param9_type i, _param10_type j, 					\
-			_param11Type k, _param11Type l)										\
-	{																			\
-		static _name##TYPE _name##VAR = NULL;									\
-		static UINT ulDllSequenceNum = 0;										\
-																				\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)							\
-			|| (NULL == GetMAPIHandle()))										\
-		{																		\
-			_name##VAR = (_name##TYPE)											\
-				::GetProcAddress(GetPrivateMAPI(), _lookup);					\
-			ulDllSequenceNum = g_ulDllSequenceNum;								\
-		}																		\
-																				\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))					\
-		{																		\
-			_name##VAR(a, b, c, d, e, f, g, h, i, j, k, l);						\
-		}																		\
+};
+
+// A stub's parameters are named a, b, c... so it can pass them on. STUB_COUNT counts its
+// parameter types, which picks the STUB_PARAMS_n and STUB_ARGS_n to use. STUB_EXPAND makes
+// MSVC split __VA_ARGS__ into separate arguments before passing them on.
+#define STUB_EXPAND(_x)			_x
+#define STUB_CONCAT_(_a, _b)	_a##_b
+#define STUB_CONCAT(_a, _b)		STUB_CONCAT_(_a, _b)
+
+#define STUB_COUNT_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _n, ...)	_n
+#define STUB_COUNT(...)	STUB_EXPAND(STUB_COUNT_(_, ##__VA_ARGS__, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0))
+
+#define STUB_PARAMS_0()																	void
+#define STUB_PARAMS_1(_t1)																_t1 a
+#define STUB_PARAMS_2(_t1, _t2)															_t1 a, _t2 b
+#define STUB_PARAMS_3(_t1, _t2, _t3)													_t1 a, _t2 b, _t3 c
+#define STUB_PARAMS_4(_t1, _t2, _t3, _t4)												_t1 a, _t2 b, _t3 c, _t4 d
+#define STUB_PARAMS_5(_t1, _t2, _t3, _t4, _t5)											STUB_PARAMS_4(_t1, _t2, _t3, _t4), _t5 e
+#define STUB_PARAMS_6(_t1, _t2, _t3, _t4, _t5, _t6)										STUB_PARAMS_5(_t1, _t2, _t3, _t4, _t5), _t6 f
+#define STUB_PARAMS_7(_t1, _t2, _t3, _t4, _t5, _t6, _t7)								STUB_PARAMS_6(_t1, _t2, _t3, _t4, _t5, _t6), _t7 g
+#define STUB_PARAMS_8(_t1, _t2, _t3, _t4, _t5, _t6, _t7, _t8)							STUB_PARAMS_7(_t1, _t2, _t3, _t4, _t5, _t6, _t7), _t8 h
+#define STUB_PARAMS_9(_t1, _t2, _t3, _t4, _t5, _t6, _t7, _t8, _t9)						STUB_PARAMS_8(_t1, _t2, _t3, _t4, _t5, _t6, _t7, _t8), _t9 i
+#define STUB_PARAMS_10(_t1, _t2, _t3, _t4, _t5, _t6, _t7, _t8, _t9, _t10)				STUB_PARAMS_9(_t1, _t2, _t3, _t4, _t5, _t6, _t7, _t8, _t9), _t10 j
+#define STUB_PARAMS_11(_t1, _t2, _t3, _t4, _t5, _t6, _t7, _t8, _t9, _t10, _t11)		STUB_PARAMS_10(_t1, _t2, _t3, _t4, _t5, _t6, _t7, _t8, _t9, _t10), _t11 k
+#define STUB_PARAMS_12(_t1, _t2, _t3, _t4, _t5, _t6, _t7, _t8, _t9, _t10, _t11, _t12)	STUB_PARAMS_11(_t1, _t2, _t3, _t4, _t5, _t6, _t7, _t8, _t9, _t10, _t11), _t12 l
+
+#define STUB_ARGS_0
+#define STUB_ARGS_1		, a
+#define STUB_ARGS_2		STUB_ARGS_1, b
+#define STUB_ARGS_3		STUB_ARGS_2, c
+#define STUB_ARGS_4		STUB_ARGS_3, d
+#define STUB_ARGS_5		STUB_ARGS_4, e
+#define STUB_ARGS_6		STUB_ARGS_5, f
+#define STUB_ARGS_7		STUB_ARGS_6, g
+#define STUB_ARGS_8		STUB_ARGS_7, h
+#define STUB_ARGS_9		STUB_ARGS_8, i
+#define STUB_ARGS_10	STUB_ARGS_9, j
+#define STUB_ARGS_11	STUB_ARGS_10, k
+#define STUB_ARGS_12	STUB_ARGS_11, l
+
+#define STUB_PARAMS(...)	STUB_EXPAND(STUB_CONCAT(STUB_PARAMS_, STUB_COUNT(__VA_ARGS__))(__VA_ARGS__))
+#define STUB_ARGS(...)		STUB_CONCAT(STUB_ARGS_, STUB_COUNT(__VA_ARGS__))
+
+#define DEFINE_STUB_FUNCTION(_linkage, _ret_type, _modifiers, _name, _lookup, _default, ...)	\
+	_linkage _ret_type _modifiers _name(STUB_PARAMS(__VA_ARGS__))								\
+	{																							\
+		return MAPIStubThunk<_ret_type (_modifiers *)(__VA_ARGS__)>::Call(						\
+			stub##_name, _default STUB_ARGS(__VA_ARGS__));										\
 	}
 
-
-#define DEFINE_STUB_FUNCTION_ORD_V12(_linkage, _modifiers,						\
-		_name, _ordinal, _param1_type, _param2_type, _param3_type,				\
-		_param4_type, _param5_type, _param6_type, _param7_type, _param8_type,	\
-		_param9_type, _param10_type, _param11Type, _param12Type)				\
-																				\
-	_linkage typedef void (_modifiers * _name##TYPE)(							\
-			_param1_type, _param2_type, _param3_type, _param4_type,				\
-			_param5_type, _param6_type, _param7_type, _param8_type,				\
-			_param9_type, _param10_type, _param11Type, _param12Type);			\
-																				\
-	_linkage void _modifiers _name(_param1_type a,								\
-			_param2_type b, _param3_type c, _param4_type d,						\
-			_param5_type e, _param6_type f, _param7_type g,						\
-			_param8_type h, _param9_type i, _param10_type j, 					\
-			_param11Type k, _param11Type l)										\
-	{																			\
-		static _name##TYPE _name##VAR = NULL;									\
-		static UINT ulDllSequenceNum = 0;										\
-																				\
-		if ( (ulDllSequenceNum != g_ulDllSequenceNum)							\
-			|| (NULL == GetMAPIHandle()))										\
-		{																		\
-			_name##VAR = (_name##TYPE)											\
-				::GetProcAddress(GetPrivateMAPI(), (LPSTR)(_ordinal));			\
-			ulDllSequenceNum = g_ulDllSequenceNum;								\
-		}																		\
-																				\
-		if ((NULL != _name##VAR) && (NULL != GetMAPIHandle()))					\
-		{																		\
-			_name##VAR(a, b, c, d, e, f, g, h, i, j, k, l);						\
-		}																		\
+#define DEFINE_STUB_FUNCTION_V(_linkage, _modifiers, _name, _lookup, ...)						\
+	_linkage void _modifiers _name(STUB_PARAMS(__VA_ARGS__))									\
+	{																							\
+		MAPIStubThunk<void (_modifiers *)(__VA_ARGS__)>::Call(stub##_name STUB_ARGS(__VA_ARGS__));	\
 	}
 
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		MAPILogonEx, ExpandFunction(MAPILogonEx,20),
-		ULONG_PTR, LPTSTR, LPTSTR, ULONG, LPMAPISESSION *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_V0(LINKAGE_EXTERN_C, STDAPICALLTYPE, 
-		MAPIUninitialize, ExpandFunction(MAPIUninitialize,0))
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, SCODE, STDMETHODCALLTYPE,
-		MAPIAllocateBuffer, ExpandFunction(MAPIAllocateBuffer,8),
-		ULONG, LPVOID FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, SCODE, STDMETHODCALLTYPE,
-		MAPIAllocateMore, ExpandFunction(MAPIAllocateMore,12),
-		ULONG, LPVOID, LPVOID FAR *, (SCODE) MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C , SCODE, STDAPICALLTYPE,
-		MAPIReallocateBuffer, ExpandFunction(MAPIReallocateBuffer,12),
-		LPVOID, ULONG, LPVOID *, (SCODE)MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, HRESULT, STDMETHODCALLTYPE,
-		MAPIAdminProfiles, ExpandFunction(MAPIAdminProfiles,8),
-		ULONG, LPPROFADMIN FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		MAPIInitialize, ExpandFunction(MAPIInitialize,4),
-		LPVOID, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		LaunchWizard, ExpandFunction(LaunchWizard,20),
-		HWND, ULONG, LPCSTR FAR *, ULONG, LPSTR, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		MAPIOpenFormMgr, ExpandFunction(MAPIOpenFormMgr,8),
-		LPMAPISESSION, LPMAPIFORMMGR FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		MAPIOpenLocalFormContainer, ExpandFunction(MAPIOpenLocalFormContainer, 4),
-		LPMAPIFORMCONTAINER FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, SCODE,
-		STDAPICALLTYPE, ScInitMapiUtil, ExpandFunction(ScInitMapiUtil,4), ULONG, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_V0(LINKAGE_EXTERN_C, STDAPICALLTYPE, DeinitMapiUtil, ExpandFunction(DeinitMapiUtil,0))
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrAllocAdviseSink, ExpandFunction(HrAllocAdviseSink,12), LPNOTIFCALLBACK, LPVOID,
-		LPMAPIADVISESINK FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, HRESULT,
-		STDAPICALLTYPE, HrThisThreadAdviseSink, ExpandFunction(HrThisThreadAdviseSink,8),
-		LPMAPIADVISESINK, LPMAPIADVISESINK FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrDispatchNotifications, ExpandFunction(HrDispatchNotifications,4), ULONG, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		ScBinFromHexBounded, ExpandFunction(ScBinFromHexBounded,12),
-		__in LPTSTR, LPBYTE, ULONG, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, BOOL,
-		STDAPICALLTYPE, FBinFromHex, ExpandFunction(FBinFromHex,8), __in LPTSTR, LPBYTE, FALSE)
-
-DEFINE_STUB_FUNCTION_V3(LINKAGE_EXTERN_C, STDAPICALLTYPE,
-		HexFromBin, ExpandFunction(HexFromBin,12), LPBYTE, int, __in LPTSTR)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C , HRESULT,
-		STDAPICALLTYPE, HrGetAutoDiscoverXML, ExpandFunction(HrGetAutoDiscoverXML,20),
-		LPCWSTR, LPCWSTR, HANDLE, ULONG, IStream **, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_10(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		BuildDisplayTable, ExpandFunction(BuildDisplayTable,40),
-		LPALLOCATEBUFFER, LPALLOCATEMORE, LPFREEBUFFER, LPMALLOC,
-		HINSTANCE, UINT, LPDTPAGE, ULONG, LPMAPITABLE *, LPTABLEDATA *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, HRESULT,
-		STDAPICALLTYPE, MAPIInitIdle, ExpandFunction(MAPIInitIdle,4), LPVOID, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_V0(LINKAGE_EXTERN_C, STDAPICALLTYPE, MAPIDeinitIdle, ExpandFunction(MAPIDeinitIdle,0))
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, FTG, STDAPICALLTYPE,
-		FtgRegisterIdleRoutine, ExpandFunction(FtgRegisterIdleRoutine,20),
-		PFNIDLE, LPVOID, short, ULONG, USHORT, NULL)
-
-DEFINE_STUB_FUNCTION_V2(LINKAGE_EXTERN_C, STDAPICALLTYPE,
-		EnableIdleRoutine, ExpandFunction(EnableIdleRoutine,8), FTG, BOOL)
-
-DEFINE_STUB_FUNCTION_V1(LINKAGE_EXTERN_C, STDAPICALLTYPE,
-		DeregisterIdleRoutine, ExpandFunction(DeregisterIdleRoutine,4), FTG)
-
-DEFINE_STUB_FUNCTION_V7(LINKAGE_EXTERN_C, STDAPICALLTYPE,
-		ChangeIdleRoutine, ExpandFunction(ChangeIdleRoutine,28),
-		FTG, PFNIDLE, LPVOID, short, ULONG, USHORT, USHORT)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		CreateIProp, ExpandFunction(CreateIProp,24),
-		LPCIID, ALLOCATEBUFFER FAR *, ALLOCATEMORE FAR *,
-		FREEBUFFER FAR *, LPVOID, LPPROPDATA FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_9(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		CreateTable, ExpandFunction(CreateTable,36),
-		LPCIID, ALLOCATEBUFFER FAR *, ALLOCATEMORE FAR *,
-		FREEBUFFER FAR *, LPVOID, ULONG, ULONG,
-		LPSPropTagArray, LPTABLEDATA FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, int, WINAPI,
-		MNLS_lstrlenW, ExpandFunction(MNLS_lstrlenW,4), LPCWSTR, 0)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, int, WINAPI,
-		MNLS_lstrcmpW, ExpandFunction(MNLS_lstrcmpW,8), LPCWSTR, LPCWSTR, 0)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, LPWSTR,
-		WINAPI, MNLS_lstrcpyW, ExpandFunction(MNLS_lstrcpyW,8), LPWSTR, LPCWSTR, NULL)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, int, WINAPI,
-		MNLS_CompareStringW, ExpandFunction(MNLS_CompareStringW,24),
-		LCID, DWORD, LPCWSTR, int, LPCWSTR, int, 0)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, int, WINAPI,
-		MNLS_MultiByteToWideChar, ExpandFunction(MNLS_MultiByteToWideChar,24),
-		UINT, DWORD, LPCSTR, int, LPWSTR, int, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_8(LINKAGE_EXTERN_C, int, WINAPI,
-		MNLS_WideCharToMultiByte, ExpandFunction(MNLS_WideCharToMultiByte,32),
-		UINT, DWORD, LPCWSTR, int, LPSTR, int, LPCSTR, BOOL FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, BOOL,
-		WINAPI, MNLS_IsBadStringPtrW, ExpandFunction(MNLS_IsBadStringPtrW,8), LPCWSTR, UINT, TRUE)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
-		FEqualNames, ExpandFunction(FEqualNames,8), LPMAPINAMEID, LPMAPINAMEID, FALSE)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		WrapStoreEntryID, ExpandFunction(WrapStoreEntryID,24),
-		ULONG, __in LPTSTR, ULONG, LPENTRYID, ULONG *, LPENTRYID *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, BOOL, WINAPI,
-		IsBadBoundedStringPtr, ExpandFunction(IsBadBoundedStringPtr,8),
-		const void FAR *, UINT, FALSE)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrQueryAllRows, ExpandFunction(HrQueryAllRows,24), LPMAPITABLE, LPSPropTagArray,
-		LPSRestriction, LPSSortOrderSet, LONG, LPSRowSet FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_4(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		ScCreateConversationIndex, ExpandFunction(ScCreateConversationIndex,16), ULONG, LPBYTE,
-		ULONG FAR *, LPBYTE FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_4(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		PropCopyMore, ExpandFunction(PropCopyMore,16),
-		LPSPropValue, LPSPropValue, ALLOCATEMORE *, LPVOID, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, ULONG,
-		STDAPICALLTYPE, UlPropSize, ExpandFunction(UlPropSize,4), LPSPropValue, 0)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
-		FPropContainsProp, ExpandFunction(FPropContainsProp,12), LPSPropValue, LPSPropValue, ULONG, FALSE)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
-		FPropCompareProp, ExpandFunction(FPropCompareProp,12), LPSPropValue, ULONG, LPSPropValue, FALSE)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, LONG, STDAPICALLTYPE,
-		LPropCompareProp, ExpandFunction(LPropCompareProp,8), LPSPropValue, LPSPropValue, 0)
-
-DEFINE_STUB_FUNCTION_4(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrAddColumns, ExpandFunction(HrAddColumns,16),
-		LPMAPITABLE, LPSPropTagArray, LPALLOCATEBUFFER, LPFREEBUFFER, MAPI_E_CALL_FAILED)
-
 typedef void (FAR * HrAddColumnsEx5ParamType)(LPSPropTagArray);
 
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrAddColumnsEx, ExpandFunction(HrAddColumnsEx,20), LPMAPITABLE, LPSPropTagArray,
-		LPALLOCATEBUFFER, LPFREEBUFFER, HrAddColumnsEx5ParamType, MAPI_E_CALL_FAILED)
-
 const FILETIME ZERO_FILETIME = { 0, 0 };
 
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, FILETIME,
-		STDAPICALLTYPE, FtMulDwDw, ExpandFunction(FtMulDwDw,8), DWORD, DWORD, ZERO_FILETIME)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, FILETIME,
-		STDAPICALLTYPE, FtAddFt, ExpandFunction(FtAddFt,16), FILETIME, FILETIME, ZERO_FILETIME)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, FILETIME, STDAPICALLTYPE,
-		FtAdcFt, ExpandFunction(FtAdcFt,20), FILETIME, FILETIME, WORD FAR *, ZERO_FILETIME)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, FILETIME,
-		STDAPICALLTYPE, FtSubFt, ExpandFunction(FtSubFt,16), FILETIME, FILETIME, ZERO_FILETIME)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, FILETIME,
-		STDAPICALLTYPE, FtMulDw, ExpandFunction(FtMulDw,12), DWORD, FILETIME, ZERO_FILETIME)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, FILETIME,
-		STDAPICALLTYPE, FtNegFt, ExpandFunction(FtNegFt,8), FILETIME, ZERO_FILETIME)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, ULONG,
-		STDAPICALLTYPE, UlAddRef, ExpandFunction(UlAddRef,4), LPVOID, 1)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, ULONG,
-		STDAPICALLTYPE, UlRelease, ExpandFunction(UlRelease,4), LPVOID, 1)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, LPTSTR,
-		STDAPICALLTYPE, SzFindCh, ExpandFunction(SzFindCh,8), LPCTSTR, USHORT, NULL)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, LPTSTR,
-		STDAPICALLTYPE, SzFindLastCh, ExpandFunction(SzFindLastCh,8), LPCTSTR, USHORT, NULL)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, LPTSTR,
-		STDAPICALLTYPE, SzFindSz, ExpandFunction(SzFindSz,8), LPCTSTR, LPCTSTR, NULL)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, unsigned int,
-		STDAPICALLTYPE, UFromSz, ExpandFunction(UFromSz,4), LPCTSTR, 0)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrGetOneProp, ExpandFunction(HrGetOneProp,12),
-		LPMAPIPROP, ULONG, LPSPropValue FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrSetOneProp, ExpandFunction(HrSetOneProp,8), LPMAPIPROP, LPSPropValue, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, BOOL,
-		STDAPICALLTYPE, FPropExists, ExpandFunction(FPropExists,8), LPMAPIPROP, ULONG, FALSE)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, LPSPropValue, STDAPICALLTYPE,
-		PpropFindProp, ExpandFunction(PpropFindProp,12), LPSPropValue, ULONG, ULONG, NULL)
-
-DEFINE_STUB_FUNCTION_V1(LINKAGE_EXTERN_C, STDAPICALLTYPE,
-		FreePadrlist, ExpandFunction(FreePadrlist,4), LPADRLIST)
-
-DEFINE_STUB_FUNCTION_V1(LINKAGE_EXTERN_C, STDAPICALLTYPE,
-		FreeProws, ExpandFunction(FreeProws,4), LPSRowSet)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrSzFromEntryID, ExpandFunction(HrSzFromEntryID,12), ULONG, LPENTRYID, __in LPTSTR FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrEntryIDFromSz, ExpandFunction(HrEntryIDFromSz,12),
-		__in LPTSTR, ULONG FAR *, LPENTRYID FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_7(LINKAGE_NO_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrComposeEID, ExpandFunction(HrComposeEID,28), LPMAPISESSION, ULONG, LPBYTE,
-		ULONG, LPENTRYID, ULONG FAR *, LPENTRYID FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_7(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrDecomposeEID, ExpandFunction(HrDecomposeEID,28), LPMAPISESSION, ULONG, LPENTRYID,
-		ULONG FAR *, LPENTRYID FAR *, ULONG FAR *, LPENTRYID FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrComposeMsgID, ExpandFunction(HrComposeMsgID,24),
-		LPMAPISESSION, ULONG, LPBYTE, ULONG, LPENTRYID, __in LPTSTR FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrDecomposeMsgID, ExpandFunction(HrDecomposeMsgID,24), LPMAPISESSION, __in LPTSTR,
-		ULONG FAR *, LPENTRYID FAR *, ULONG FAR *, LPENTRYID FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, HRESULT,
-		STDMETHODCALLTYPE, OpenStreamOnFile, ExpandFunction(OpenStreamOnFile,24),
-		LPALLOCATEBUFFER, LPFREEBUFFER, ULONG,
-		__in LPCTSTR, __in_opt LPCTSTR, LPSTREAM FAR *, MAPI_E_CALL_FAILED)
-
-#ifdef _INC_WINAPIFAMILY
-DEFINE_STUB_FUNCTION_7(LINKAGE_EXTERN_C, _Check_return_ HRESULT,
-		STDMETHODCALLTYPE, OpenTnefStream, ExpandFunction(OpenTnefStream,28), LPVOID, LPSTREAM,
-		__in LPTSTR, ULONG, LPMESSAGE, WORD, LPITNEF FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_8(LINKAGE_EXTERN_C, _Check_return_ HRESULT, STDMETHODCALLTYPE,
-		OpenTnefStreamEx, ExpandFunction(OpenTnefStreamEx,32), LPVOID, LPSTREAM, __in LPTSTR,
-		ULONG, LPMESSAGE, WORD, LPADRBOOK, LPITNEF FAR *, MAPI_E_CALL_FAILED)
-#else
-DEFINE_STUB_FUNCTION_7(LINKAGE_EXTERN_C, HRESULT,
-		STDMETHODCALLTYPE, OpenTnefStream, ExpandFunction(OpenTnefStream,28), LPVOID, LPSTREAM,
-		__in LPTSTR, ULONG, LPMESSAGE, WORD, LPITNEF FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_8(LINKAGE_EXTERN_C, HRESULT, STDMETHODCALLTYPE,
-		OpenTnefStreamEx, ExpandFunction(OpenTnefStreamEx,32), LPVOID, LPSTREAM, __in LPTSTR,
-		ULONG, LPMESSAGE, WORD, LPADRBOOK, LPITNEF FAR *, MAPI_E_CALL_FAILED)
-#endif
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, HRESULT, STDMETHODCALLTYPE,
-		GetTnefStreamCodepage, ExpandFunction(GetTnefStreamCodepage,12),
-		LPSTREAM, ULONG FAR *, ULONG FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, ULONG,
-		STDAPICALLTYPE, UlFromSzHex, ExpandFunction(UlFromSzHex,4), LPCTSTR, 0)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		ScCountNotifications, ExpandFunction(ScCountNotifications,12),
-		int, LPNOTIFICATION, ULONG FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_4(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		ScCopyNotifications, ExpandFunction(ScCopyNotifications,16),
-		int, LPNOTIFICATION, LPVOID, ULONG FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, SCODE,
-		STDAPICALLTYPE, ScRelocNotifications, ExpandFunction(ScRelocNotifications,20), int,
-		LPNOTIFICATION, LPVOID, LPVOID, ULONG FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		ScCountProps, ExpandFunction(ScCountProps,12),
-		int, LPSPropValue, ULONG FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_4(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		ScCopyProps, ExpandFunction(ScCopyProps,16),
-		int, LPSPropValue, LPVOID, ULONG FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		ScRelocProps, ExpandFunction(ScRelocProps,20),
-		int, LPSPropValue, LPVOID, LPVOID, ULONG FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, LPSPropValue, STDAPICALLTYPE,
-		LpValFindProp, ExpandFunction(LpValFindProp,12), ULONG, ULONG, LPSPropValue, NULL)
-
-DEFINE_STUB_FUNCTION_4(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		ScDupPropset, ExpandFunction(ScDupPropset,16),
-		int, LPSPropValue, LPALLOCATEBUFFER, LPSPropValue FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, BOOL,
-		STDAPICALLTYPE, FBadRglpszW, ExpandFunction(FBadRglpszW,8), __in LPWSTR FAR *, ULONG, TRUE)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, BOOL,
-		STDAPICALLTYPE, FBadRowSet, ExpandFunction(FBadRowSet,4), LPSRowSet, TRUE)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
-		FBadRglpNameID, ExpandFunction(FBadRglpNameID,8), LPMAPINAMEID FAR *, ULONG, TRUE)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, ULONG,
-		STDAPICALLTYPE, FBadPropTag, ExpandFunction(FBadPropTag,4), ULONG, TRUE)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, ULONG,
-		STDAPICALLTYPE, FBadRow, ExpandFunction(FBadRow,4), LPSRow, TRUE)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, ULONG,
-		STDAPICALLTYPE, FBadProp, ExpandFunction(FBadProp,4), LPSPropValue, TRUE)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, ULONG,
-		STDAPICALLTYPE, FBadColumnSet, ExpandFunction(FBadColumnSet,4), LPSPropTagArray, TRUE)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		RTFSync, ExpandFunction(RTFSync,12), LPMESSAGE, ULONG, __out BOOL FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		WrapCompressedRTFStream, ExpandFunction(WrapCompressedRTFStream,12),
-		__in LPSTREAM, ULONG, __out LPSTREAM FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		__ValidateParameters, ExpandFunction(__ValidateParameters,8),
-		METHODS, void *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		__CPPValidateParameters, ExpandFunction(__CPPValidateParameters,8),
-		METHODS, const LPVOID, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_2(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
-		HrValidateParameters, ExpandFunction(HrValidateParameters,8),
-		METHODS, LPVOID FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, ULONG,
-		STDAPICALLTYPE, FBadSortOrderSet, ExpandFunction(FBadSortOrderSet,4), LPSSortOrderSet, TRUE)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, BOOL,
-		STDAPICALLTYPE, FBadEntryList, ExpandFunction(FBadEntryList,4), LPENTRYLIST, TRUE)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, ULONG,
-		STDAPICALLTYPE, FBadRestriction, ExpandFunction(FBadRestriction,4), LPSRestriction, TRUE)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		ScUNCFromLocalPath, ExpandFunction(ScUNCFromLocalPath,12), __in LPSTR, __in LPSTR, UINT, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		ScLocalPathFromUNC, ExpandFunction(ScLocalPathFromUNC,12), __in LPSTR, __in LPSTR, UINT, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_4(LINKAGE_EXTERN_C, HRESULT,
-		STDAPICALLTYPE, HrIStorageFromStream, ExpandFunction(HrIStorageFromStream,16),
-		LPUNKNOWN, LPCIID, ULONG, LPSTORAGE FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, HRESULT,
-		STDAPICALLTYPE, HrValidateIPMSubtree, ExpandFunction(HrValidateIPMSubtree,20), LPMDB, ULONG,
-		ULONG FAR *, LPSPropValue FAR *, LPMAPIERROR FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
-		OpenIMsgSession, ExpandFunction(OpenIMsgSession,12),
-		LPMALLOC, ULONG, LPMSGSESS FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_V1(LINKAGE_EXTERN_C, STDAPICALLTYPE,
-		CloseIMsgSession, ExpandFunction(CloseIMsgSession,4), LPMSGSESS)
-
-DEFINE_STUB_FUNCTION_11(LINKAGE_EXTERN_C, SCODE,
-		STDAPICALLTYPE, OpenIMsgOnIStg, ExpandFunction(OpenIMsgOnIStg,44), LPMSGSESS, LPALLOCATEBUFFER,
-		LPALLOCATEMORE, LPFREEBUFFER, LPMALLOC, LPVOID, LPSTORAGE,
-		MSGCALLRELEASE FAR *, ULONG, ULONG, LPMESSAGE FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_4(LINKAGE_EXTERN_C, HRESULT,
-		STDAPICALLTYPE, SetAttribIMsgOnIStg, ExpandFunction(SetAttribIMsgOnIStg,16), LPVOID, LPSPropTagArray,
-		LPSPropAttrArray, LPSPropProblemArray FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C, HRESULT,
-		STDAPICALLTYPE, GetAttribIMsgOnIStg, ExpandFunction(GetAttribIMsgOnIStg,12), LPVOID,
-		LPSPropTagArray, LPSPropAttrArray FAR *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C, SCODE,
-		STDAPICALLTYPE, MapStorageSCode, ExpandFunction(MapStorageSCode,4), SCODE, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_4(LINKAGE_EXTERN_C, SCODE, STDMETHODCALLTYPE, ScMAPIXFromSMAPI,
-		"ScMAPIXFromSMAPI", LHANDLE, ULONG, LPCIID, LPMAPISESSION FAR *, MAPI_E_CALL_FAILED);
-
-DEFINE_STUB_FUNCTION_11(LINKAGE_EXTERN_C, ULONG, FAR PASCAL, MAPIAddress, "MAPIAddress",
-	LHANDLE, ULONG_PTR, LPSTR, ULONG, LPSTR, ULONG, lpMapiRecipDesc,
-	FLAGS, ULONG, LPULONG, lpMapiRecipDesc FAR *, (ULONG)MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, ULONG, FAR PASCAL, MAPIReadMail, "MAPIReadMail",
-		LHANDLE, ULONG_PTR, LPSTR, FLAGS, ULONG, lpMapiMessage FAR *, (ULONG)MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, ULONG, FAR PASCAL, MAPIResolveName, "MAPIResolveName",
-		LHANDLE, ULONG_PTR, LPSTR, FLAGS, ULONG, lpMapiRecipDesc FAR *, (ULONG)MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
-		MAPISendDocuments, "MAPISendDocuments",
-		ULONG_PTR, LPSTR, LPSTR, LPSTR, ULONG, (ULONG) MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
-		MAPILogon, "MAPILogon",
-		ULONG_PTR, LPSTR, LPSTR, FLAGS, ULONG, LPLHANDLE, (ULONG) MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_4( LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
-		MAPILogoff, "MAPILogoff", LHANDLE, ULONG_PTR, FLAGS, ULONG, (ULONG) MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
-		MAPISendMail, "MAPISendMail",
-		LHANDLE, ULONG_PTR, lpMapiMessage, FLAGS, ULONG, (ULONG) MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
-		MAPISaveMail, "MAPISaveMail", LHANDLE, ULONG_PTR, lpMapiMessage,
-		FLAGS, ULONG, LPSTR, (ULONG) MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_7(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
-		MAPIFindNext, "MAPIFindNext",
-		LHANDLE, ULONG_PTR, LPSTR, LPSTR, FLAGS, ULONG, LPSTR, (ULONG) MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
-		MAPIDeleteMail, "MAPIDeleteMail",
-		LHANDLE, ULONG_PTR, LPSTR, FLAGS, ULONG, (ULONG) MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
-		MAPIDetails, "MAPIDetails",
-		LHANDLE, ULONG_PTR, lpMapiRecipDesc, FLAGS, ULONG, (ULONG) MAPI_E_CALL_FAILED)
-
-
-DEFINE_STUB_FUNCTION_V1(LINKAGE_EXTERN_C, STDAPICALLTYPE, MAPICrashRecovery, ExpandFunction(MAPICrashRecovery,4), ULONG)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C , ULONG, STDAPICALLTYPE, MAPIFreeBuffer, ExpandFunction(MAPIFreeBuffer,4), LPVOID, 0)
-
-DEFINE_STUB_FUNCTION_0(LINKAGE_EXTERN_C , LPMALLOC, STDAPICALLTYPE, MAPIGetDefaultMalloc, ExpandFunction(MAPIGetDefaultMalloc,0), NULL)
-
-DEFINE_STUB_FUNCTION_6(LINKAGE_EXTERN_C , HRESULT, STDAPICALLTYPE, OpenStreamOnFileW, ExpandFunction(OpenStreamOnFileW,24), LPALLOCATEBUFFER, LPFREEBUFFER,
-		ULONG, LPWSTR, LPWSTR, LPSTREAM FAR*, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_7(LINKAGE_EXTERN_C , HRESULT, STDAPICALLTYPE, HrCreateNewWrappedObject, ExpandFunction(HrCreateNewWrappedObject,28), 
-	void*, ULONG, ULONG, const IID*, const ULONG*, BOOL, void**, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_EXTERN_C , HRESULT, STDAPICALLTYPE, HrOpenOfflineObj, ExpandFunction(HrOpenOfflineObj,20), 
-	ULONG, LPCWSTR, const GUID*, const GUID*, IMAPIOfflineMgr**, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_3(LINKAGE_EXTERN_C , HRESULT, STDAPICALLTYPE, HrCreateOfflineObj, ExpandFunction(HrCreateOfflineObj,12), 
-	ULONG, MAPIOFFLINE_CREATEINFO*, IMAPIOfflineMgr**, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_4(LINKAGE_EXTERN_C, HRESULT, STDMETHODCALLTYPE, WrapCompressedRTFStreamEx, ExpandFunction(WrapCompressedRTFStreamEx,16),
-		LPSTREAM, CONST RTF_WCSINFO *, LPSTREAM *, RTF_WCSRETINFO *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C , BOOL, WINAPI, GetDefCachedMode, ExpandFunction(GetDefCachedMode,4), 
-	BOOL*, FALSE)
-
-DEFINE_STUB_FUNCTION_1(LINKAGE_EXTERN_C , BOOL, WINAPI, GetDefCachedModeDownloadPubFoldFavs, ExpandFunction(GetDefCachedModeDownloadPubFoldFavs,4), 
-	BOOL*, FALSE)
-
-DEFINE_STUB_FUNCTION_9(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI, HrOpenABEntryWithExchangeContext, ExpandFunction(HrOpenABEntryWithExchangeContext,36),
-	LPMAPISESSION, LPMAPIUID, LPADRBOOK, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_12(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI, HrDoABDetailsWithExchangeContext, ExpandFunction(HrDoABDetailsWithExchangeContext,48),
-	LPMAPISESSION, LPMAPIUID, LPADRBOOK, ULONG_PTR *, LPFNDISMISS, LPVOID, ULONG, LPENTRYID, LPFNBUTTON, LPVOID, LPSTR, ULONG, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_11(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI, HrDoABDetailsWithProviderUID, ExpandFunction(HrDoABDetailsWithProviderUID,44),
-	LPMAPIUID, LPADRBOOK, ULONG_PTR *, LPFNDISMISS, LPVOID, ULONG, LPENTRYID, LPFNBUTTON, LPVOID, LPSTR, ULONG, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_8(LINKAGE_EXTERN_C, HRESULT, WINAPI, HrOpenABEntryUsingDefaultContext, ExpandFunction(HrOpenABEntryUsingDefaultContext,32),
-	LPMAPISESSION, LPADRBOOK, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_8(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI, HrOpenABEntryWithProviderUID, ExpandFunction(HrOpenABEntryWithProviderUID,32),
-	LPMAPIUID, LPADRBOOK, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_8(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI, HrOpenABEntryWithProviderUIDSupport, ExpandFunction(HrOpenABEntryWithProviderUIDSupport,32),
-	LPMAPIUID, LPMAPISUP, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_8(LINKAGE_EXTERN_C, HRESULT, WINAPI, HrOpenABEntryWithResolvedRow, ExpandFunction(HrOpenABEntryWithResolvedRow,32),
-	LPSRow, LPADRBOOK, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_9(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI, HrCompareABEntryIDsWithExchangeContext, ExpandFunction(HrCompareABEntryIDsWithExchangeContext,36),
-	LPMAPISESSION, LPMAPIUID, LPADRBOOK, ULONG, LPENTRYID, ULONG, LPENTRYID, ULONG, ULONG *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_7(LINKAGE_EXTERN_C, HRESULT, WINAPI, HrOpenABEntryWithSupport, ExpandFunction(HrOpenABEntryWithSupport,28),
-	LPMAPISUP, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *, MAPI_E_CALL_FAILED)
-
-DEFINE_STUB_FUNCTION_5(LINKAGE_NO_EXTERN_C , HRESULT, WINAPI, HrGetGALFromEmsmdbUID, ExpandFunction(HrGetGALFromEmsmdbUID,20), 
-	LPMAPISESSION, LPADRBOOK, LPMAPIUID, ULONG *, LPENTRYID *, MAPI_E_CALL_FAILED)
-
+#include "MapiStubList.inl"
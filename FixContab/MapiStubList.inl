@@ -0,0 +1,585 @@
+// Every export the stub library forwards to MAPI, as one DEFINE_STUB_FUNCTION per export, or
+// DEFINE_STUB_FUNCTION_V for one returning void. Each gives the linkage, return type, calling
+// convention, name, the name or (LPCSTR) ordinal it's looked up by, what it returns when MAPI
+// doesn't have it, and then its parameter types.
+// MapiStubLibrary.cpp includes this list several times, with the macros defined differently for
+// each pass, to build the table of exports and then the stubs that call through it.
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		MAPILogonEx, ExpandFunction(MAPILogonEx,20), MAPI_E_CALL_FAILED,
+		ULONG_PTR, LPTSTR, LPTSTR, ULONG, LPMAPISESSION *)
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		MAPIUninitialize, ExpandFunction(MAPIUninitialize,0))
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDMETHODCALLTYPE,
+		MAPIAllocateBuffer, ExpandFunction(MAPIAllocateBuffer,8), MAPI_E_CALL_FAILED,
+		ULONG, LPVOID FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDMETHODCALLTYPE,
+		MAPIAllocateMore, ExpandFunction(MAPIAllocateMore,12), (SCODE) MAPI_E_CALL_FAILED,
+		ULONG, LPVOID, LPVOID FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		MAPIReallocateBuffer, ExpandFunction(MAPIReallocateBuffer,12), (SCODE)MAPI_E_CALL_FAILED,
+		LPVOID, ULONG, LPVOID *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDMETHODCALLTYPE,
+		MAPIAdminProfiles, ExpandFunction(MAPIAdminProfiles,8), MAPI_E_CALL_FAILED,
+		ULONG, LPPROFADMIN FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		MAPIInitialize, ExpandFunction(MAPIInitialize,4), MAPI_E_CALL_FAILED,
+		LPVOID)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		LaunchWizard, ExpandFunction(LaunchWizard,20), MAPI_E_CALL_FAILED,
+		HWND, ULONG, LPCSTR FAR *, ULONG, LPSTR)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		MAPIOpenFormMgr, ExpandFunction(MAPIOpenFormMgr,8), MAPI_E_CALL_FAILED,
+		LPMAPISESSION, LPMAPIFORMMGR FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		MAPIOpenLocalFormContainer, ExpandFunction(MAPIOpenLocalFormContainer, 4), MAPI_E_CALL_FAILED,
+		LPMAPIFORMCONTAINER FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScInitMapiUtil, ExpandFunction(ScInitMapiUtil,4), MAPI_E_CALL_FAILED,
+		ULONG)
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		DeinitMapiUtil, ExpandFunction(DeinitMapiUtil,0))
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrAllocAdviseSink, ExpandFunction(HrAllocAdviseSink,12), MAPI_E_CALL_FAILED,
+		LPNOTIFCALLBACK, LPVOID, LPMAPIADVISESINK FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrThisThreadAdviseSink, ExpandFunction(HrThisThreadAdviseSink,8), MAPI_E_CALL_FAILED,
+		LPMAPIADVISESINK, LPMAPIADVISESINK FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrDispatchNotifications, ExpandFunction(HrDispatchNotifications,4), MAPI_E_CALL_FAILED,
+		ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScBinFromHexBounded, ExpandFunction(ScBinFromHexBounded,12), MAPI_E_CALL_FAILED,
+		__in LPTSTR, LPBYTE, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
+		FBinFromHex, ExpandFunction(FBinFromHex,8), FALSE,
+		__in LPTSTR, LPBYTE)
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		HexFromBin, ExpandFunction(HexFromBin,12),
+		LPBYTE, int, __in LPTSTR)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrGetAutoDiscoverXML, ExpandFunction(HrGetAutoDiscoverXML,20), MAPI_E_CALL_FAILED,
+		LPCWSTR, LPCWSTR, HANDLE, ULONG, IStream **)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		BuildDisplayTable, ExpandFunction(BuildDisplayTable,40), MAPI_E_CALL_FAILED,
+		LPALLOCATEBUFFER, LPALLOCATEMORE, LPFREEBUFFER, LPMALLOC, HINSTANCE, UINT, LPDTPAGE, ULONG,
+		LPMAPITABLE *, LPTABLEDATA *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		MAPIInitIdle, ExpandFunction(MAPIInitIdle,4), MAPI_E_CALL_FAILED,
+		LPVOID)
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		MAPIDeinitIdle, ExpandFunction(MAPIDeinitIdle,0))
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, FTG, STDAPICALLTYPE,
+		FtgRegisterIdleRoutine, ExpandFunction(FtgRegisterIdleRoutine,20), NULL,
+		PFNIDLE, LPVOID, short, ULONG, USHORT)
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		EnableIdleRoutine, ExpandFunction(EnableIdleRoutine,8),
+		FTG, BOOL)
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		DeregisterIdleRoutine, ExpandFunction(DeregisterIdleRoutine,4),
+		FTG)
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		ChangeIdleRoutine, ExpandFunction(ChangeIdleRoutine,28),
+		FTG, PFNIDLE, LPVOID, short, ULONG, USHORT, USHORT)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		CreateIProp, ExpandFunction(CreateIProp,24), MAPI_E_CALL_FAILED,
+		LPCIID, ALLOCATEBUFFER FAR *, ALLOCATEMORE FAR *, FREEBUFFER FAR *, LPVOID,
+		LPPROPDATA FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		CreateTable, ExpandFunction(CreateTable,36), MAPI_E_CALL_FAILED,
+		LPCIID, ALLOCATEBUFFER FAR *, ALLOCATEMORE FAR *, FREEBUFFER FAR *, LPVOID, ULONG, ULONG,
+		LPSPropTagArray, LPTABLEDATA FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, int, WINAPI,
+		MNLS_lstrlenW, ExpandFunction(MNLS_lstrlenW,4), 0,
+		LPCWSTR)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, int, WINAPI,
+		MNLS_lstrcmpW, ExpandFunction(MNLS_lstrcmpW,8), 0,
+		LPCWSTR, LPCWSTR)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, LPWSTR, WINAPI,
+		MNLS_lstrcpyW, ExpandFunction(MNLS_lstrcpyW,8), NULL,
+		LPWSTR, LPCWSTR)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, int, WINAPI,
+		MNLS_CompareStringW, ExpandFunction(MNLS_CompareStringW,24), 0,
+		LCID, DWORD, LPCWSTR, int, LPCWSTR, int)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, int, WINAPI,
+		MNLS_MultiByteToWideChar, ExpandFunction(MNLS_MultiByteToWideChar,24), MAPI_E_CALL_FAILED,
+		UINT, DWORD, LPCSTR, int, LPWSTR, int)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, int, WINAPI,
+		MNLS_WideCharToMultiByte, ExpandFunction(MNLS_WideCharToMultiByte,32), MAPI_E_CALL_FAILED,
+		UINT, DWORD, LPCWSTR, int, LPSTR, int, LPCSTR, BOOL FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, WINAPI,
+		MNLS_IsBadStringPtrW, ExpandFunction(MNLS_IsBadStringPtrW,8), TRUE,
+		LPCWSTR, UINT)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
+		FEqualNames, ExpandFunction(FEqualNames,8), FALSE,
+		LPMAPINAMEID, LPMAPINAMEID)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		WrapStoreEntryID, ExpandFunction(WrapStoreEntryID,24), MAPI_E_CALL_FAILED,
+		ULONG, __in LPTSTR, ULONG, LPENTRYID, ULONG *, LPENTRYID *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, WINAPI,
+		IsBadBoundedStringPtr, ExpandFunction(IsBadBoundedStringPtr,8), FALSE,
+		const void FAR *, UINT)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrQueryAllRows, ExpandFunction(HrQueryAllRows,24), MAPI_E_CALL_FAILED,
+		LPMAPITABLE, LPSPropTagArray, LPSRestriction, LPSSortOrderSet, LONG, LPSRowSet FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScCreateConversationIndex, ExpandFunction(ScCreateConversationIndex,16), MAPI_E_CALL_FAILED,
+		ULONG, LPBYTE, ULONG FAR *, LPBYTE FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		PropCopyMore, ExpandFunction(PropCopyMore,16), MAPI_E_CALL_FAILED,
+		LPSPropValue, LPSPropValue, ALLOCATEMORE *, LPVOID)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		UlPropSize, ExpandFunction(UlPropSize,4), 0,
+		LPSPropValue)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
+		FPropContainsProp, ExpandFunction(FPropContainsProp,12), FALSE,
+		LPSPropValue, LPSPropValue, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
+		FPropCompareProp, ExpandFunction(FPropCompareProp,12), FALSE,
+		LPSPropValue, ULONG, LPSPropValue)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, LONG, STDAPICALLTYPE,
+		LPropCompareProp, ExpandFunction(LPropCompareProp,8), 0,
+		LPSPropValue, LPSPropValue)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrAddColumns, ExpandFunction(HrAddColumns,16), MAPI_E_CALL_FAILED,
+		LPMAPITABLE, LPSPropTagArray, LPALLOCATEBUFFER, LPFREEBUFFER)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrAddColumnsEx, ExpandFunction(HrAddColumnsEx,20), MAPI_E_CALL_FAILED,
+		LPMAPITABLE, LPSPropTagArray, LPALLOCATEBUFFER, LPFREEBUFFER, HrAddColumnsEx5ParamType)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, FILETIME, STDAPICALLTYPE,
+		FtMulDwDw, ExpandFunction(FtMulDwDw,8), ZERO_FILETIME,
+		DWORD, DWORD)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, FILETIME, STDAPICALLTYPE,
+		FtAddFt, ExpandFunction(FtAddFt,16), ZERO_FILETIME,
+		FILETIME, FILETIME)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, FILETIME, STDAPICALLTYPE,
+		FtAdcFt, ExpandFunction(FtAdcFt,20), ZERO_FILETIME,
+		FILETIME, FILETIME, WORD FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, FILETIME, STDAPICALLTYPE,
+		FtSubFt, ExpandFunction(FtSubFt,16), ZERO_FILETIME,
+		FILETIME, FILETIME)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, FILETIME, STDAPICALLTYPE,
+		FtMulDw, ExpandFunction(FtMulDw,12), ZERO_FILETIME,
+		DWORD, FILETIME)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, FILETIME, STDAPICALLTYPE,
+		FtNegFt, ExpandFunction(FtNegFt,8), ZERO_FILETIME,
+		FILETIME)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		UlAddRef, ExpandFunction(UlAddRef,4), 1,
+		LPVOID)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		UlRelease, ExpandFunction(UlRelease,4), 1,
+		LPVOID)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, LPTSTR, STDAPICALLTYPE,
+		SzFindCh, ExpandFunction(SzFindCh,8), NULL,
+		LPCTSTR, USHORT)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, LPTSTR, STDAPICALLTYPE,
+		SzFindLastCh, ExpandFunction(SzFindLastCh,8), NULL,
+		LPCTSTR, USHORT)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, LPTSTR, STDAPICALLTYPE,
+		SzFindSz, ExpandFunction(SzFindSz,8), NULL,
+		LPCTSTR, LPCTSTR)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, unsigned int, STDAPICALLTYPE,
+		UFromSz, ExpandFunction(UFromSz,4), 0,
+		LPCTSTR)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrGetOneProp, ExpandFunction(HrGetOneProp,12), MAPI_E_CALL_FAILED,
+		LPMAPIPROP, ULONG, LPSPropValue FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrSetOneProp, ExpandFunction(HrSetOneProp,8), MAPI_E_CALL_FAILED,
+		LPMAPIPROP, LPSPropValue)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
+		FPropExists, ExpandFunction(FPropExists,8), FALSE,
+		LPMAPIPROP, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, LPSPropValue, STDAPICALLTYPE,
+		PpropFindProp, ExpandFunction(PpropFindProp,12), NULL,
+		LPSPropValue, ULONG, ULONG)
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		FreePadrlist, ExpandFunction(FreePadrlist,4),
+		LPADRLIST)
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		FreeProws, ExpandFunction(FreeProws,4),
+		LPSRowSet)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrSzFromEntryID, ExpandFunction(HrSzFromEntryID,12), MAPI_E_CALL_FAILED,
+		ULONG, LPENTRYID, __in LPTSTR FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrEntryIDFromSz, ExpandFunction(HrEntryIDFromSz,12), MAPI_E_CALL_FAILED,
+		__in LPTSTR, ULONG FAR *, LPENTRYID FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_NO_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrComposeEID, ExpandFunction(HrComposeEID,28), MAPI_E_CALL_FAILED,
+		LPMAPISESSION, ULONG, LPBYTE, ULONG, LPENTRYID, ULONG FAR *, LPENTRYID FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrDecomposeEID, ExpandFunction(HrDecomposeEID,28), MAPI_E_CALL_FAILED,
+		LPMAPISESSION, ULONG, LPENTRYID, ULONG FAR *, LPENTRYID FAR *, ULONG FAR *,
+		LPENTRYID FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrComposeMsgID, ExpandFunction(HrComposeMsgID,24), MAPI_E_CALL_FAILED,
+		LPMAPISESSION, ULONG, LPBYTE, ULONG, LPENTRYID, __in LPTSTR FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrDecomposeMsgID, ExpandFunction(HrDecomposeMsgID,24), MAPI_E_CALL_FAILED,
+		LPMAPISESSION, __in LPTSTR, ULONG FAR *, LPENTRYID FAR *, ULONG FAR *, LPENTRYID FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDMETHODCALLTYPE,
+		OpenStreamOnFile, ExpandFunction(OpenStreamOnFile,24), MAPI_E_CALL_FAILED,
+		LPALLOCATEBUFFER, LPFREEBUFFER, ULONG, __in LPCTSTR, __in_opt LPCTSTR, LPSTREAM FAR *)
+
+#ifdef _INC_WINAPIFAMILY
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, _Check_return_ HRESULT, STDMETHODCALLTYPE,
+		OpenTnefStream, ExpandFunction(OpenTnefStream,28), MAPI_E_CALL_FAILED,
+		LPVOID, LPSTREAM, __in LPTSTR, ULONG, LPMESSAGE, WORD, LPITNEF FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, _Check_return_ HRESULT, STDMETHODCALLTYPE,
+		OpenTnefStreamEx, ExpandFunction(OpenTnefStreamEx,32), MAPI_E_CALL_FAILED,
+		LPVOID, LPSTREAM, __in LPTSTR, ULONG, LPMESSAGE, WORD, LPADRBOOK, LPITNEF FAR *)
+#else
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDMETHODCALLTYPE,
+		OpenTnefStream, ExpandFunction(OpenTnefStream,28), MAPI_E_CALL_FAILED,
+		LPVOID, LPSTREAM, __in LPTSTR, ULONG, LPMESSAGE, WORD, LPITNEF FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDMETHODCALLTYPE,
+		OpenTnefStreamEx, ExpandFunction(OpenTnefStreamEx,32), MAPI_E_CALL_FAILED,
+		LPVOID, LPSTREAM, __in LPTSTR, ULONG, LPMESSAGE, WORD, LPADRBOOK, LPITNEF FAR *)
+#endif
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDMETHODCALLTYPE,
+		GetTnefStreamCodepage, ExpandFunction(GetTnefStreamCodepage,12), MAPI_E_CALL_FAILED,
+		LPSTREAM, ULONG FAR *, ULONG FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		UlFromSzHex, ExpandFunction(UlFromSzHex,4), 0,
+		LPCTSTR)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScCountNotifications, ExpandFunction(ScCountNotifications,12), MAPI_E_CALL_FAILED,
+		int, LPNOTIFICATION, ULONG FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScCopyNotifications, ExpandFunction(ScCopyNotifications,16), MAPI_E_CALL_FAILED,
+		int, LPNOTIFICATION, LPVOID, ULONG FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScRelocNotifications, ExpandFunction(ScRelocNotifications,20), MAPI_E_CALL_FAILED,
+		int, LPNOTIFICATION, LPVOID, LPVOID, ULONG FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScCountProps, ExpandFunction(ScCountProps,12), MAPI_E_CALL_FAILED,
+		int, LPSPropValue, ULONG FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScCopyProps, ExpandFunction(ScCopyProps,16), MAPI_E_CALL_FAILED,
+		int, LPSPropValue, LPVOID, ULONG FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScRelocProps, ExpandFunction(ScRelocProps,20), MAPI_E_CALL_FAILED,
+		int, LPSPropValue, LPVOID, LPVOID, ULONG FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, LPSPropValue, STDAPICALLTYPE,
+		LpValFindProp, ExpandFunction(LpValFindProp,12), NULL,
+		ULONG, ULONG, LPSPropValue)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScDupPropset, ExpandFunction(ScDupPropset,16), MAPI_E_CALL_FAILED,
+		int, LPSPropValue, LPALLOCATEBUFFER, LPSPropValue FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
+		FBadRglpszW, ExpandFunction(FBadRglpszW,8), TRUE,
+		__in LPWSTR FAR *, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
+		FBadRowSet, ExpandFunction(FBadRowSet,4), TRUE,
+		LPSRowSet)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
+		FBadRglpNameID, ExpandFunction(FBadRglpNameID,8), TRUE,
+		LPMAPINAMEID FAR *, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		FBadPropTag, ExpandFunction(FBadPropTag,4), TRUE,
+		ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		FBadRow, ExpandFunction(FBadRow,4), TRUE,
+		LPSRow)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		FBadProp, ExpandFunction(FBadProp,4), TRUE,
+		LPSPropValue)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		FBadColumnSet, ExpandFunction(FBadColumnSet,4), TRUE,
+		LPSPropTagArray)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		RTFSync, ExpandFunction(RTFSync,12), MAPI_E_CALL_FAILED,
+		LPMESSAGE, ULONG, __out BOOL FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		WrapCompressedRTFStream, ExpandFunction(WrapCompressedRTFStream,12), MAPI_E_CALL_FAILED,
+		__in LPSTREAM, ULONG, __out LPSTREAM FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		__ValidateParameters, ExpandFunction(__ValidateParameters,8), MAPI_E_CALL_FAILED,
+		METHODS, void *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		__CPPValidateParameters, ExpandFunction(__CPPValidateParameters,8), MAPI_E_CALL_FAILED,
+		METHODS, const LPVOID)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrValidateParameters, ExpandFunction(HrValidateParameters,8), MAPI_E_CALL_FAILED,
+		METHODS, LPVOID FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		FBadSortOrderSet, ExpandFunction(FBadSortOrderSet,4), TRUE,
+		LPSSortOrderSet)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, STDAPICALLTYPE,
+		FBadEntryList, ExpandFunction(FBadEntryList,4), TRUE,
+		LPENTRYLIST)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		FBadRestriction, ExpandFunction(FBadRestriction,4), TRUE,
+		LPSRestriction)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScUNCFromLocalPath, ExpandFunction(ScUNCFromLocalPath,12), MAPI_E_CALL_FAILED,
+		__in LPSTR, __in LPSTR, UINT)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		ScLocalPathFromUNC, ExpandFunction(ScLocalPathFromUNC,12), MAPI_E_CALL_FAILED,
+		__in LPSTR, __in LPSTR, UINT)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrIStorageFromStream, ExpandFunction(HrIStorageFromStream,16), MAPI_E_CALL_FAILED,
+		LPUNKNOWN, LPCIID, ULONG, LPSTORAGE FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrValidateIPMSubtree, ExpandFunction(HrValidateIPMSubtree,20), MAPI_E_CALL_FAILED,
+		LPMDB, ULONG, ULONG FAR *, LPSPropValue FAR *, LPMAPIERROR FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		OpenIMsgSession, ExpandFunction(OpenIMsgSession,12), MAPI_E_CALL_FAILED,
+		LPMALLOC, ULONG, LPMSGSESS FAR *)
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		CloseIMsgSession, ExpandFunction(CloseIMsgSession,4),
+		LPMSGSESS)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		OpenIMsgOnIStg, ExpandFunction(OpenIMsgOnIStg,44), MAPI_E_CALL_FAILED,
+		LPMSGSESS, LPALLOCATEBUFFER, LPALLOCATEMORE, LPFREEBUFFER, LPMALLOC, LPVOID, LPSTORAGE,
+		MSGCALLRELEASE FAR *, ULONG, ULONG, LPMESSAGE FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		SetAttribIMsgOnIStg, ExpandFunction(SetAttribIMsgOnIStg,16), MAPI_E_CALL_FAILED,
+		LPVOID, LPSPropTagArray, LPSPropAttrArray, LPSPropProblemArray FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		GetAttribIMsgOnIStg, ExpandFunction(GetAttribIMsgOnIStg,12), MAPI_E_CALL_FAILED,
+		LPVOID, LPSPropTagArray, LPSPropAttrArray FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDAPICALLTYPE,
+		MapStorageSCode, ExpandFunction(MapStorageSCode,4), MAPI_E_CALL_FAILED,
+		SCODE)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, SCODE, STDMETHODCALLTYPE,
+		ScMAPIXFromSMAPI, "ScMAPIXFromSMAPI", MAPI_E_CALL_FAILED,
+		LHANDLE, ULONG, LPCIID, LPMAPISESSION FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPIAddress, "MAPIAddress", (ULONG)MAPI_E_CALL_FAILED,
+		LHANDLE, ULONG_PTR, LPSTR, ULONG, LPSTR, ULONG, lpMapiRecipDesc, FLAGS, ULONG, LPULONG,
+		lpMapiRecipDesc FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPIReadMail, "MAPIReadMail", (ULONG)MAPI_E_CALL_FAILED,
+		LHANDLE, ULONG_PTR, LPSTR, FLAGS, ULONG, lpMapiMessage FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPIResolveName, "MAPIResolveName", (ULONG)MAPI_E_CALL_FAILED,
+		LHANDLE, ULONG_PTR, LPSTR, FLAGS, ULONG, lpMapiRecipDesc FAR *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPISendDocuments, "MAPISendDocuments", (ULONG) MAPI_E_CALL_FAILED,
+		ULONG_PTR, LPSTR, LPSTR, LPSTR, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPILogon, "MAPILogon", (ULONG) MAPI_E_CALL_FAILED,
+		ULONG_PTR, LPSTR, LPSTR, FLAGS, ULONG, LPLHANDLE)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPILogoff, "MAPILogoff", (ULONG) MAPI_E_CALL_FAILED,
+		LHANDLE, ULONG_PTR, FLAGS, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPISendMail, "MAPISendMail", (ULONG) MAPI_E_CALL_FAILED,
+		LHANDLE, ULONG_PTR, lpMapiMessage, FLAGS, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPISaveMail, "MAPISaveMail", (ULONG) MAPI_E_CALL_FAILED,
+		LHANDLE, ULONG_PTR, lpMapiMessage, FLAGS, ULONG, LPSTR)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPIFindNext, "MAPIFindNext", (ULONG) MAPI_E_CALL_FAILED,
+		LHANDLE, ULONG_PTR, LPSTR, LPSTR, FLAGS, ULONG, LPSTR)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPIDeleteMail, "MAPIDeleteMail", (ULONG) MAPI_E_CALL_FAILED,
+		LHANDLE, ULONG_PTR, LPSTR, FLAGS, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, FAR PASCAL,
+		MAPIDetails, "MAPIDetails", (ULONG) MAPI_E_CALL_FAILED,
+		LHANDLE, ULONG_PTR, lpMapiRecipDesc, FLAGS, ULONG)
+
+
+DEFINE_STUB_FUNCTION_V(LINKAGE_EXTERN_C, STDAPICALLTYPE,
+		MAPICrashRecovery, ExpandFunction(MAPICrashRecovery,4),
+		ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, ULONG, STDAPICALLTYPE,
+		MAPIFreeBuffer, ExpandFunction(MAPIFreeBuffer,4), 0,
+		LPVOID)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, LPMALLOC, STDAPICALLTYPE,
+		MAPIGetDefaultMalloc, ExpandFunction(MAPIGetDefaultMalloc,0), NULL)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		OpenStreamOnFileW, ExpandFunction(OpenStreamOnFileW,24), MAPI_E_CALL_FAILED,
+		LPALLOCATEBUFFER, LPFREEBUFFER, ULONG, LPWSTR, LPWSTR, LPSTREAM FAR*)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrCreateNewWrappedObject, ExpandFunction(HrCreateNewWrappedObject,28), MAPI_E_CALL_FAILED,
+		void*, ULONG, ULONG, const IID*, const ULONG*, BOOL, void**)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrOpenOfflineObj, ExpandFunction(HrOpenOfflineObj,20), MAPI_E_CALL_FAILED,
+		ULONG, LPCWSTR, const GUID*, const GUID*, IMAPIOfflineMgr**)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDAPICALLTYPE,
+		HrCreateOfflineObj, ExpandFunction(HrCreateOfflineObj,12), MAPI_E_CALL_FAILED,
+		ULONG, MAPIOFFLINE_CREATEINFO*, IMAPIOfflineMgr**)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, STDMETHODCALLTYPE,
+		WrapCompressedRTFStreamEx, ExpandFunction(WrapCompressedRTFStreamEx,16), MAPI_E_CALL_FAILED,
+		LPSTREAM, CONST RTF_WCSINFO *, LPSTREAM *, RTF_WCSRETINFO *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, WINAPI,
+		GetDefCachedMode, ExpandFunction(GetDefCachedMode,4), FALSE,
+		BOOL*)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, BOOL, WINAPI,
+		GetDefCachedModeDownloadPubFoldFavs, ExpandFunction(GetDefCachedModeDownloadPubFoldFavs,4), FALSE,
+		BOOL*)
+
+DEFINE_STUB_FUNCTION(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI,
+		HrOpenABEntryWithExchangeContext, ExpandFunction(HrOpenABEntryWithExchangeContext,36), MAPI_E_CALL_FAILED,
+		LPMAPISESSION, LPMAPIUID, LPADRBOOK, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI,
+		HrDoABDetailsWithExchangeContext, ExpandFunction(HrDoABDetailsWithExchangeContext,48), MAPI_E_CALL_FAILED,
+		LPMAPISESSION, LPMAPIUID, LPADRBOOK, ULONG_PTR *, LPFNDISMISS, LPVOID, ULONG, LPENTRYID,
+		LPFNBUTTON, LPVOID, LPSTR, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI,
+		HrDoABDetailsWithProviderUID, ExpandFunction(HrDoABDetailsWithProviderUID,44), MAPI_E_CALL_FAILED,
+		LPMAPIUID, LPADRBOOK, ULONG_PTR *, LPFNDISMISS, LPVOID, ULONG, LPENTRYID, LPFNBUTTON,
+		LPVOID, LPSTR, ULONG)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, WINAPI,
+		HrOpenABEntryUsingDefaultContext, ExpandFunction(HrOpenABEntryUsingDefaultContext,32), MAPI_E_CALL_FAILED,
+		LPMAPISESSION, LPADRBOOK, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI,
+		HrOpenABEntryWithProviderUID, ExpandFunction(HrOpenABEntryWithProviderUID,32), MAPI_E_CALL_FAILED,
+		LPMAPIUID, LPADRBOOK, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI,
+		HrOpenABEntryWithProviderUIDSupport, ExpandFunction(HrOpenABEntryWithProviderUIDSupport,32), MAPI_E_CALL_FAILED,
+		LPMAPIUID, LPMAPISUP, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, WINAPI,
+		HrOpenABEntryWithResolvedRow, ExpandFunction(HrOpenABEntryWithResolvedRow,32), MAPI_E_CALL_FAILED,
+		LPSRow, LPADRBOOK, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI,
+		HrCompareABEntryIDsWithExchangeContext, ExpandFunction(HrCompareABEntryIDsWithExchangeContext,36), MAPI_E_CALL_FAILED,
+		LPMAPISESSION, LPMAPIUID, LPADRBOOK, ULONG, LPENTRYID, ULONG, LPENTRYID, ULONG, ULONG *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_EXTERN_C, HRESULT, WINAPI,
+		HrOpenABEntryWithSupport, ExpandFunction(HrOpenABEntryWithSupport,28), MAPI_E_CALL_FAILED,
+		LPMAPISUP, ULONG, LPENTRYID, LPCIID, ULONG, ULONG *, LPUNKNOWN *)
+
+DEFINE_STUB_FUNCTION(LINKAGE_NO_EXTERN_C, HRESULT, WINAPI,
+		HrGetGALFromEmsmdbUID, ExpandFunction(HrGetGALFromEmsmdbUID,20), MAPI_E_CALL_FAILED,
+		LPMAPISESSION, LPADRBOOK, LPMAPIUID, ULONG *, LPENTRYID *)
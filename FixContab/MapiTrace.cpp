@@ -0,0 +1,1524 @@
+#include "stdafx.h"
+#include "MapiTrace.h"
+#include <MAPIX.h>
+#include <MAPIUtil.h>
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "InMemoryMapi.h"
+#include "StubUtils.h"
+
+// Exports are looked up by the names MAPI gives them
+#if defined(_M_X64) || defined(_M_ARM)
+#define ExpandFunction(fn, c)		#fn
+#elif defined(_M_IX86)
+#define ExpandFunction(fn, c)		#fn"@"#c
+#else
+#error "Unsupported Platform"
+#endif
+
+const char rgchTraceSignature[4] = { 'F', 'C', 'T', '1' };
+
+// Stands in for a count or size where the pointer was null
+const ULONG ulTraceNull = 0xFFFFFFFF;
+
+// Limit on a single count or size, so a corrupt trace can't have us allocate gigabytes
+const ULONG cMaxTraceValue = 0x1000000;
+
+enum TraceCallID
+{
+	tcInitialize = 1,
+	tcUninitialize,
+	tcAdminProfiles,
+	tcQueryAllRows,
+	tcGetProfileTable,
+	tcAdminServices,
+	tcGetMsgServiceTable,
+	tcGetProviderTable,
+	tcOpenProfileSection,
+	tcSaveChanges,
+	tcGetProps,
+	tcSetProps,
+	tcDeleteProps,
+	tcSetColumns,
+	tcRestrict,
+	tcQueryRows,
+};
+
+struct TraceRecord
+{
+	ULONG ulCall;
+	ULONG ulObject;
+	std::vector<BYTE> args;
+	HRESULT hr;
+	ULONG ulResultObject;
+	std::vector<BYTE> data;
+};
+
+/*
+ *  Encoding
+ */
+static void PutULONG(std::vector<BYTE>& buf, ULONG ul)
+{
+	auto lpb = reinterpret_cast<const BYTE*>(&ul);
+	buf.insert(buf.end(), lpb, lpb + sizeof(ul));
+}
+
+static void PutBytes(std::vector<BYTE>& buf, const void* lpv, ULONG cb)
+{
+	PutULONG(buf, cb);
+	auto lpb = static_cast<const BYTE*>(lpv);
+	if (cb) buf.insert(buf.end(), lpb, lpb + cb);
+}
+
+static void PutStringA(std::vector<BYTE>& buf, LPCSTR sz)
+{
+	if (!sz)
+	{
+		PutULONG(buf, ulTraceNull);
+		return;
+	}
+
+	PutBytes(buf, sz, static_cast<ULONG>(strlen(sz)));
+}
+
+// Stored as UTF-16 code units, whatever the size of WCHAR
+static void PutStringW(std::vector<BYTE>& buf, LPCWSTR wz)
+{
+	if (!wz)
+	{
+		PutULONG(buf, ulTraceNull);
+		return;
+	}
+
+	auto cch = static_cast<ULONG>(wcslen(wz));
+	PutULONG(buf, cch);
+	for (ULONG i = 0; i < cch; i++)
+	{
+		auto wch = static_cast<WORD>(wz[i]);
+		auto lpb = reinterpret_cast<const BYTE*>(&wch);
+		buf.insert(buf.end(), lpb, lpb + sizeof(wch));
+	}
+}
+
+static void PutTags(std::vector<BYTE>& buf, const SPropTagArray* lpTags)
+{
+	if (!lpTags)
+	{
+		PutULONG(buf, ulTraceNull);
+		return;
+	}
+
+	PutULONG(buf, lpTags->cValues);
+	for (ULONG i = 0; i < lpTags->cValues; i++)
+	{
+		PutULONG(buf, lpTags->aulPropTag[i]);
+	}
+}
+
+static void PutProp(std::vector<BYTE>& buf, const SPropValue& prop)
+{
+	switch (PROP_TYPE(prop.ulPropTag))
+	{
+	case PT_I2:
+		PutULONG(buf, prop.ulPropTag);
+		PutULONG(buf, static_cast<USHORT>(prop.Value.i));
+		break;
+	case PT_BOOLEAN:
+		PutULONG(buf, prop.ulPropTag);
+		PutULONG(buf, prop.Value.b);
+		break;
+	case PT_LONG:
+	case PT_ERROR:
+		PutULONG(buf, prop.ulPropTag);
+		PutULONG(buf, prop.Value.ul);
+		break;
+	case PT_NULL:
+	case PT_OBJECT:
+		PutULONG(buf, prop.ulPropTag);
+		PutULONG(buf, static_cast<ULONG>(prop.Value.x));
+		break;
+	case PT_I8:
+	case PT_SYSTIME:
+	case PT_CURRENCY:
+	case PT_DOUBLE:
+	case PT_APPTIME:
+		// Every eight byte member of the union shares its storage with li
+		PutULONG(buf, prop.ulPropTag);
+		PutBytes(buf, &prop.Value.li, sizeof(prop.Value.li));
+		break;
+	case PT_STRING8:
+		PutULONG(buf, prop.ulPropTag);
+		PutStringA(buf, prop.Value.lpszA);
+		break;
+	case PT_UNICODE:
+		PutULONG(buf, prop.ulPropTag);
+		PutStringW(buf, prop.Value.lpszW);
+		break;
+	case PT_BINARY:
+		PutULONG(buf, prop.ulPropTag);
+		PutBytes(buf, prop.Value.bin.lpb, prop.Value.bin.cb);
+		break;
+	case PT_CLSID:
+		PutULONG(buf, prop.ulPropTag);
+		if (prop.Value.lpguid)
+		{
+			PutBytes(buf, prop.Value.lpguid, sizeof(GUID));
+		}
+		else
+		{
+			PutULONG(buf, ulTraceNull);
+		}
+		break;
+	case PT_MV_LONG:
+		PutULONG(buf, prop.ulPropTag);
+		PutULONG(buf, prop.Value.MVl.cValues);
+		for (ULONG i = 0; i < prop.Value.MVl.cValues; i++)
+		{
+			PutULONG(buf, static_cast<ULONG>(prop.Value.MVl.lpl[i]));
+		}
+		break;
+	case PT_MV_BINARY:
+		PutULONG(buf, prop.ulPropTag);
+		PutULONG(buf, prop.Value.MVbin.cValues);
+		for (ULONG i = 0; i < prop.Value.MVbin.cValues; i++)
+		{
+			PutBytes(buf, prop.Value.MVbin.lpbin[i].lpb, prop.Value.MVbin.lpbin[i].cb);
+		}
+		break;
+	case PT_MV_STRING8:
+		PutULONG(buf, prop.ulPropTag);
+		PutULONG(buf, prop.Value.MVszA.cValues);
+		for (ULONG i = 0; i < prop.Value.MVszA.cValues; i++)
+		{
+			PutStringA(buf, prop.Value.MVszA.lppszA[i]);
+		}
+		break;
+	case PT_MV_UNICODE:
+		PutULONG(buf, prop.ulPropTag);
+		PutULONG(buf, prop.Value.MVszW.cValues);
+		for (ULONG i = 0; i < prop.Value.MVszW.cValues; i++)
+		{
+			PutStringW(buf, prop.Value.MVszW.lppszW[i]);
+		}
+		break;
+	default:
+		// Types this tool never reads are recorded as errors rather than guessed at
+		PutULONG(buf, CHANGE_PROP_TYPE(prop.ulPropTag, PT_ERROR));
+		PutULONG(buf, static_cast<ULONG>(MAPI_E_NO_SUPPORT));
+		break;
+	}
+}
+
+static void PutProps(std::vector<BYTE>& buf, ULONG cValues, const SPropValue* lpProps)
+{
+	if (!lpProps)
+	{
+		PutULONG(buf, ulTraceNull);
+		return;
+	}
+
+	PutULONG(buf, cValues);
+	for (ULONG i = 0; i < cValues; i++)
+	{
+		PutProp(buf, lpProps[i]);
+	}
+}
+
+static void PutRows(std::vector<BYTE>& buf, const SRowSet* lpRows)
+{
+	if (!lpRows)
+	{
+		PutULONG(buf, ulTraceNull);
+		return;
+	}
+
+	PutULONG(buf, lpRows->cRows);
+	for (ULONG i = 0; i < lpRows->cRows; i++)
+	{
+		PutProps(buf, lpRows->aRow[i].cValues, lpRows->aRow[i].lpProps);
+	}
+}
+
+// Restrictions are only ever arguments, so they are written but never read back
+static void PutRestriction(std::vector<BYTE>& buf, const SRestriction* lpRes)
+{
+	if (!lpRes)
+	{
+		PutULONG(buf, ulTraceNull);
+		return;
+	}
+
+	PutULONG(buf, lpRes->rt);
+	switch (lpRes->rt)
+	{
+	case RES_AND:
+	case RES_OR:
+		PutULONG(buf, lpRes->res.resAnd.cRes);
+		for (ULONG i = 0; i < lpRes->res.resAnd.cRes; i++)
+		{
+			PutRestriction(buf, &lpRes->res.resAnd.lpRes[i]);
+		}
+		break;
+	case RES_NOT:
+		PutRestriction(buf, lpRes->res.resNot.lpRes);
+		break;
+	case RES_CONTENT:
+		PutULONG(buf, lpRes->res.resContent.ulFuzzyLevel);
+		PutULONG(buf, lpRes->res.resContent.ulPropTag);
+		PutProps(buf, 1, lpRes->res.resContent.lpProp);
+		break;
+	case RES_PROPERTY:
+		PutULONG(buf, lpRes->res.resProperty.relop);
+		PutULONG(buf, lpRes->res.resProperty.ulPropTag);
+		PutProps(buf, 1, lpRes->res.resProperty.lpProp);
+		break;
+	case RES_COMPAREPROPS:
+		PutULONG(buf, lpRes->res.resCompareProps.relop);
+		PutULONG(buf, lpRes->res.resCompareProps.ulPropTag1);
+		PutULONG(buf, lpRes->res.resCompareProps.ulPropTag2);
+		break;
+	case RES_BITMASK:
+		PutULONG(buf, lpRes->res.resBitMask.relBMR);
+		PutULONG(buf, lpRes->res.resBitMask.ulPropTag);
+		PutULONG(buf, lpRes->res.resBitMask.ulMask);
+		break;
+	case RES_SIZE:
+		PutULONG(buf, lpRes->res.resSize.relop);
+		PutULONG(buf, lpRes->res.resSize.ulPropTag);
+		PutULONG(buf, lpRes->res.resSize.cb);
+		break;
+	case RES_EXIST:
+		PutULONG(buf, lpRes->res.resExist.ulPropTag);
+		break;
+	case RES_SUBRESTRICTION:
+		PutULONG(buf, lpRes->res.resSub.ulSubObject);
+		PutRestriction(buf, lpRes->res.resSub.lpRes);
+		break;
+	case RES_COMMENT:
+		PutProps(buf, lpRes->res.resComment.cValues, lpRes->res.resComment.lpProp);
+		PutRestriction(buf, lpRes->res.resComment.lpRes);
+		break;
+	}
+}
+
+static void PutSortOrder(std::vector<BYTE>& buf, const SSortOrderSet* lpSortOrderSet)
+{
+	if (!lpSortOrderSet)
+	{
+		PutULONG(buf, ulTraceNull);
+		return;
+	}
+
+	PutULONG(buf, lpSortOrderSet->cSorts);
+	PutULONG(buf, lpSortOrderSet->cCategories);
+	PutULONG(buf, lpSortOrderSet->cExpanded);
+	for (ULONG i = 0; i < lpSortOrderSet->cSorts; i++)
+	{
+		PutULONG(buf, lpSortOrderSet->aSort[i].ulPropTag);
+		PutULONG(buf, lpSortOrderSet->aSort[i].ulOrder);
+	}
+}
+
+/*
+ *  Decoding
+ *		Values are rebuilt with the in-memory allocators, which replay binds the stubs to,
+ *		so callers free them with MAPIFreeBuffer and FreeProws as usual.
+ */
+class TraceReader
+{
+public:
+	explicit TraceReader(const std::vector<BYTE>& buf) : m_buf(buf), m_ib(0)
+	{
+	}
+
+	bool GetULONG(_Out_ ULONG* lpul)
+	{
+		if (m_buf.size() - m_ib < sizeof(ULONG)) return false;
+		memcpy(lpul, m_buf.data() + m_ib, sizeof(ULONG));
+		m_ib += sizeof(ULONG);
+		return true;
+	}
+
+	// Points lppb into the buffer. A value recorded from a null pointer comes back as nullptr.
+	bool GetBytes(_Out_ const BYTE** lppb, _Out_ ULONG* lpcb, ULONG cbUnit = 1)
+	{
+		*lppb = nullptr;
+		if (!GetULONG(lpcb)) return false;
+		if (*lpcb == ulTraceNull)
+		{
+			*lpcb = 0;
+			return true;
+		}
+
+		if (*lpcb > cMaxTraceValue || (m_buf.size() - m_ib) / cbUnit < *lpcb) return false;
+		*lppb = m_buf.data() + m_ib;
+		m_ib += static_cast<size_t>(*lpcb) * cbUnit;
+		return true;
+	}
+
+	bool IsAtEnd() const
+	{
+		return m_ib == m_buf.size();
+	}
+
+private:
+	const std::vector<BYTE>& m_buf;
+	size_t m_ib;
+};
+
+// Copies cb bytes into a block chained to lpParent, followed by cbZero bytes of zero
+static bool CopyMore(LPVOID lpParent, const BYTE* lpb, ULONG cb, ULONG cbZero, _Out_ LPVOID* lppCopy)
+{
+	*lppCopy = nullptr;
+	if (FAILED(InMemoryAllocateMore(cb + cbZero, lpParent, lppCopy))) return false;
+
+	auto lpbCopy = static_cast<BYTE*>(*lppCopy);
+	if (cb) memcpy(lpbCopy, lpb, cb);
+	memset(lpbCopy + cb, 0, cbZero);
+	return true;
+}
+
+static bool GetStringA(TraceReader& reader, LPVOID lpParent, _Out_ LPSTR* lpszA)
+{
+	*lpszA = nullptr;
+	const BYTE* lpb = nullptr;
+	ULONG cb = 0;
+	if (!reader.GetBytes(&lpb, &cb)) return false;
+	if (!lpb) return true;
+
+	return CopyMore(lpParent, lpb, cb, sizeof(CHAR), reinterpret_cast<LPVOID*>(lpszA));
+}
+
+static bool GetStringW(TraceReader& reader, LPVOID lpParent, _Out_ LPWSTR* lpszW)
+{
+	*lpszW = nullptr;
+	const BYTE* lpb = nullptr;
+	ULONG cch = 0;
+	if (!reader.GetBytes(&lpb, &cch, sizeof(WORD))) return false;
+	if (!lpb) return true;
+
+	LPVOID lpv = nullptr;
+	if (FAILED(InMemoryAllocateMore((cch + 1) * sizeof(WCHAR), lpParent, &lpv))) return false;
+
+	auto wz = static_cast<LPWSTR>(lpv);
+	for (ULONG i = 0; i < cch; i++)
+	{
+		WORD wch = 0;
+		memcpy(&wch, lpb + i * sizeof(WORD), sizeof(WORD));
+		wz[i] = static_cast<WCHAR>(wch);
+	}
+
+	wz[cch] = L'\0';
+	*lpszW = wz;
+	return true;
+}
+
+static bool GetBinary(TraceReader& reader, LPVOID lpParent, _Out_ SBinary& bin)
+{
+	bin = {};
+	const BYTE* lpb = nullptr;
+	if (!reader.GetBytes(&lpb, &bin.cb)) return false;
+	if (!lpb || !bin.cb) return true;
+
+	return CopyMore(lpParent, lpb, bin.cb, 0, reinterpret_cast<LPVOID*>(&bin.lpb));
+}
+
+// Allocates the array for a multi-valued property
+template <typename T> static bool GetArray(TraceReader& reader, LPVOID lpParent, _Out_ ULONG* lpcValues, _Out_ T** lppValues)
+{
+	*lppValues = nullptr;
+	if (!reader.GetULONG(lpcValues) || *lpcValues > cMaxTraceValue) return false;
+
+	LPVOID lpv = nullptr;
+	if (FAILED(InMemoryAllocateMore(*lpcValues * sizeof(T) + 1, lpParent, &lpv))) return false;
+	*lppValues = static_cast<T*>(lpv);
+	return true;
+}
+
+static bool GetProp(TraceReader& reader, LPVOID lpParent, _Out_ SPropValue& prop)
+{
+	prop = {};
+	if (!reader.GetULONG(&prop.ulPropTag)) return false;
+
+	ULONG ul = 0;
+	const BYTE* lpb = nullptr;
+	ULONG cb = 0;
+	switch (PROP_TYPE(prop.ulPropTag))
+	{
+	case PT_I2:
+		if (!reader.GetULONG(&ul)) return false;
+		prop.Value.i = static_cast<short>(ul);
+		return true;
+	case PT_BOOLEAN:
+		if (!reader.GetULONG(&ul)) return false;
+		prop.Value.b = static_cast<unsigned short>(ul);
+		return true;
+	case PT_LONG:
+	case PT_ERROR:
+		return reader.GetULONG(&prop.Value.ul);
+	case PT_NULL:
+	case PT_OBJECT:
+		if (!reader.GetULONG(&ul)) return false;
+		prop.Value.x = static_cast<LONG>(ul);
+		return true;
+	case PT_I8:
+	case PT_SYSTIME:
+	case PT_CURRENCY:
+	case PT_DOUBLE:
+	case PT_APPTIME:
+		if (!reader.GetBytes(&lpb, &cb) || cb != sizeof(prop.Value.li)) return false;
+		memcpy(&prop.Value.li, lpb, sizeof(prop.Value.li));
+		return true;
+	case PT_STRING8:
+		return GetStringA(reader, lpParent, &prop.Value.lpszA);
+	case PT_UNICODE:
+		return GetStringW(reader, lpParent, &prop.Value.lpszW);
+	case PT_BINARY:
+		return GetBinary(reader, lpParent, prop.Value.bin);
+	case PT_CLSID:
+		if (!reader.GetBytes(&lpb, &cb)) return false;
+		if (!lpb) return true;
+		return cb == sizeof(GUID) && CopyMore(lpParent, lpb, cb, 0, reinterpret_cast<LPVOID*>(&prop.Value.lpguid));
+	case PT_MV_LONG:
+		if (!GetArray(reader, lpParent, &prop.Value.MVl.cValues, &prop.Value.MVl.lpl)) return false;
+		for (ULONG i = 0; i < prop.Value.MVl.cValues; i++)
+		{
+			if (!reader.GetULONG(&ul)) return false;
+			prop.Value.MVl.lpl[i] = static_cast<LONG>(ul);
+		}
+		return true;
+	case PT_MV_BINARY:
+		if (!GetArray(reader, lpParent, &prop.Value.MVbin.cValues, &prop.Value.MVbin.lpbin)) return false;
+		for (ULONG i = 0; i < prop.Value.MVbin.cValues; i++)
+		{
+			if (!GetBinary(reader, lpParent, prop.Value.MVbin.lpbin[i])) return false;
+		}
+		return true;
+	case PT_MV_STRING8:
+		if (!GetArray(reader, lpParent, &prop.Value.MVszA.cValues, &prop.Value.MVszA.lppszA)) return false;
+		for (ULONG i = 0; i < prop.Value.MVszA.cValues; i++)
+		{
+			if (!GetStringA(reader, lpParent, &prop.Value.MVszA.lppszA[i])) return false;
+		}
+		return true;
+	case PT_MV_UNICODE:
+		if (!GetArray(reader, lpParent, &prop.Value.MVszW.cValues, &prop.Value.MVszW.lppszW)) return false;
+		for (ULONG i = 0; i < prop.Value.MVszW.cValues; i++)
+		{
+			if (!GetStringW(reader, lpParent, &prop.Value.MVszW.lppszW[i])) return false;
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Allocates the array in a block of its own, which everything it points to is chained to
+static bool GetProps(TraceReader& reader, _Out_ ULONG* lpcValues, _Out_ LPSPropValue* lppProps)
+{
+	*lpcValues = 0;
+	*lppProps = nullptr;
+
+	ULONG cValues = 0;
+	if (!reader.GetULONG(&cValues)) return false;
+	if (cValues == ulTraceNull) return true;
+	if (cValues > cMaxTraceValue) return false;
+
+	LPVOID lpv = nullptr;
+	if (FAILED(InMemoryAllocateBuffer(cValues * sizeof(SPropValue) + 1, &lpv))) return false;
+
+	auto lpProps = static_cast<LPSPropValue>(lpv);
+	for (ULONG i = 0; i < cValues; i++)
+	{
+		if (!GetProp(reader, lpProps, lpProps[i]))
+		{
+			InMemoryFreeBuffer(lpProps);
+			return false;
+		}
+	}
+
+	*lpcValues = cValues;
+	*lppProps = lpProps;
+	return true;
+}
+
+// Each row gets a block of its own, as FreeProws expects
+static bool GetRows(TraceReader& reader, _Out_ LPSRowSet* lppRows)
+{
+	*lppRows = nullptr;
+
+	ULONG cRows = 0;
+	if (!reader.GetULONG(&cRows)) return false;
+	if (cRows == ulTraceNull) return true;
+	if (cRows > cMaxTraceValue) return false;
+
+	LPVOID lpv = nullptr;
+	if (FAILED(InMemoryAllocateBuffer(static_cast<ULONG>(CbNewSRowSet(cRows)), &lpv))) return false;
+
+	auto lpRows = static_cast<LPSRowSet>(lpv);
+	lpRows->cRows = 0;
+	for (ULONG i = 0; i < cRows; i++)
+	{
+		auto& row = lpRows->aRow[i];
+		row.ulAdrEntryPad = 0;
+		if (!GetProps(reader, &row.cValues, &row.lpProps))
+		{
+			InMemoryFreeProws(lpRows);
+			return false;
+		}
+
+		lpRows->cRows++;
+	}
+
+	*lppRows = lpRows;
+	return true;
+}
+
+/*
+ *  Session
+ */
+static bool g_fTracing = false;
+static bool g_fReplaying = false;
+
+// Set once writing the trace fails or the replay diverges
+static bool g_fTraceFailed = false;
+
+// The trace being written while recording
+static FILE* g_lpTraceFile = nullptr;
+
+// Number given to the last object created while recording
+static ULONG g_ulLastTraceObject = 0;
+
+// The calls being replayed, and the next one due
+static std::vector<TraceRecord> g_replayRecords;
+static size_t g_iNextReplay = 0;
+
+static void RecordCall(const TraceRecord& record)
+{
+	std::vector<BYTE> buf;
+	PutULONG(buf, record.ulCall);
+	PutULONG(buf, record.ulObject);
+	PutBytes(buf, record.args.data(), static_cast<ULONG>(record.args.size()));
+	PutULONG(buf, static_cast<ULONG>(record.hr));
+	PutULONG(buf, record.ulResultObject);
+	PutBytes(buf, record.data.data(), static_cast<ULONG>(record.data.size()));
+
+	if (!g_lpTraceFile || fwrite(buf.data(), buf.size(), 1, g_lpTraceFile) != 1) g_fTraceFailed = true;
+}
+
+// Takes the next recorded call, which must be the same call on the same object with the same
+// arguments. Once the replay has diverged every call fails, since nothing after it can be trusted.
+static bool ReplayCall(TraceRecord& record)
+{
+	if (!g_fTraceFailed && g_iNextReplay < g_replayRecords.size())
+	{
+		const auto& next = g_replayRecords[g_iNextReplay];
+		if (next.ulCall == record.ulCall && next.ulObject == record.ulObject && next.args == record.args)
+		{
+			g_iNextReplay++;
+			record.hr = next.hr;
+			record.ulResultObject = next.ulResultObject;
+			record.data = next.data;
+			return true;
+		}
+	}
+
+	if (!g_fTraceFailed)
+	{
+		wprintf(L"Replay diverged from the trace at call %u\n", static_cast<unsigned>(g_iNextReplay + 1));
+		g_fTraceFailed = true;
+	}
+
+	record.hr = MAPI_E_CALL_FAILED;
+	return false;
+}
+
+// Replays a call which returns property values
+static void ReplayProps(TraceRecord& record, _Out_ ULONG* lpcValues, _Out_ LPSPropValue* lppProps)
+{
+	*lpcValues = 0;
+	*lppProps = nullptr;
+	if (!ReplayCall(record) || FAILED(record.hr)) return;
+
+	TraceReader reader(record.data);
+	if (!GetProps(reader, lpcValues, lppProps))
+	{
+		g_fTraceFailed = true;
+		record.hr = MAPI_E_CORRUPT_DATA;
+	}
+}
+
+// Replays a call which returns rows
+static void ReplayRows(TraceRecord& record, _Out_ LPSRowSet* lppRows)
+{
+	*lppRows = nullptr;
+	if (!ReplayCall(record) || FAILED(record.hr)) return;
+
+	TraceReader reader(record.data);
+	if (!GetRows(reader, lppRows))
+	{
+		g_fTraceFailed = true;
+		record.hr = MAPI_E_CORRUPT_DATA;
+	}
+}
+
+/*
+ *  Traced objects
+ *		While recording each wraps the object it was created for and passes the calls
+ *		it traces on to it. In replay there is nothing behind it.
+ */
+template <typename I> class TracedObject : public I
+{
+public:
+	TracedObject(I* lpInner, ULONG ulObject, REFIID iid, const IID* lpiidBase)
+		: m_cRef(1), m_lpInner(lpInner), m_ulObject(ulObject), m_iid(iid), m_lpiidBase(lpiidBase)
+	{
+	}
+
+	virtual ~TracedObject()
+	{
+		if (m_lpInner) m_lpInner->Release();
+	}
+
+	STDMETHODIMP QueryInterface(REFIID riid, LPVOID FAR* ppvObj) override
+	{
+		if (!ppvObj) return MAPI_E_INVALID_PARAMETER;
+		*ppvObj = nullptr;
+		if (!IsEqualIID(riid, IID_IUnknown) && !IsEqualIID(riid, m_iid) &&
+			!(m_lpiidBase && IsEqualIID(riid, *m_lpiidBase)))
+		{
+			return MAPI_E_INTERFACE_NOT_SUPPORTED;
+		}
+
+		AddRef();
+		*ppvObj = static_cast<I*>(this);
+		return S_OK;
+	}
+
+	STDMETHODIMP_(ULONG) AddRef() override
+	{
+		return ++m_cRef;
+	}
+
+	STDMETHODIMP_(ULONG) Release() override
+	{
+		auto cRef = --m_cRef;
+		if (!cRef) delete this;
+		return cRef;
+	}
+
+	I* GetInner() const
+	{
+		return m_lpInner;
+	}
+
+	ULONG GetObjectID() const
+	{
+		return m_ulObject;
+	}
+
+protected:
+	std::atomic<ULONG> m_cRef;
+	I* m_lpInner;
+	ULONG m_ulObject;
+	const IID& m_iid;
+	const IID* m_lpiidBase;
+};
+
+// Hands back the object a call returned. While recording that's a wrapper around what the call
+// gave us, numbered in the record. In replay it's a stand in with the number that was recorded.
+template <typename T, typename I> static void OpenResult(TraceRecord& record, I* lpInner, _Out_ I** lppResult)
+{
+	*lppResult = nullptr;
+	if (g_fReplaying)
+	{
+		if (SUCCEEDED(record.hr) && record.ulResultObject) *lppResult = new T(nullptr, record.ulResultObject);
+	}
+	else if (lpInner)
+	{
+		record.ulResultObject = ++g_ulLastTraceObject;
+		*lppResult = new T(lpInner, record.ulResultObject);
+	}
+}
+
+/*
+ *  TracedTable
+ */
+class TracedTable : public TracedObject<IMAPITable>
+{
+public:
+	TracedTable(LPMAPITABLE lpInner, ULONG ulObject) : TracedObject(lpInner, ulObject, IID_IMAPITable, nullptr)
+	{
+	}
+
+	MAPI_IMAPITABLE_METHODS(IMPL)
+};
+
+STDMETHODIMP TracedTable::GetLastError(HRESULT, ULONG, LPMAPIERROR FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::Advise(ULONG, LPMAPIADVISESINK, ULONG_PTR FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::Unadvise(ULONG_PTR)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::GetStatus(ULONG FAR*, ULONG FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::SetColumns(LPSPropTagArray lpPropTagArray, ULONG ulFlags)
+{
+	TraceRecord record = { tcSetColumns, m_ulObject };
+	PutTags(record.args, lpPropTagArray);
+	PutULONG(record.args, ulFlags);
+
+	if (g_fReplaying)
+	{
+		ReplayCall(record);
+		return record.hr;
+	}
+
+	record.hr = m_lpInner->SetColumns(lpPropTagArray, ulFlags);
+	RecordCall(record);
+	return record.hr;
+}
+
+STDMETHODIMP TracedTable::QueryColumns(ULONG, LPSPropTagArray FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::GetRowCount(ULONG, ULONG FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::SeekRow(BOOKMARK, LONG, LONG FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::SeekRowApprox(ULONG, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::QueryPosition(ULONG FAR*, ULONG FAR*, ULONG FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::FindRow(LPSRestriction, BOOKMARK, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::Restrict(LPSRestriction lpRestriction, ULONG ulFlags)
+{
+	TraceRecord record = { tcRestrict, m_ulObject };
+	PutRestriction(record.args, lpRestriction);
+	PutULONG(record.args, ulFlags);
+
+	if (g_fReplaying)
+	{
+		ReplayCall(record);
+		return record.hr;
+	}
+
+	record.hr = m_lpInner->Restrict(lpRestriction, ulFlags);
+	RecordCall(record);
+	return record.hr;
+}
+
+STDMETHODIMP TracedTable::CreateBookmark(BOOKMARK FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::FreeBookmark(BOOKMARK)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::SortTable(LPSSortOrderSet, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::QuerySortOrder(LPSSortOrderSet FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::QueryRows(LONG lRowCount, ULONG ulFlags, LPSRowSet FAR* lppRows)
+{
+	if (!lppRows) return MAPI_E_INVALID_PARAMETER;
+
+	TraceRecord record = { tcQueryRows, m_ulObject };
+	PutULONG(record.args, static_cast<ULONG>(lRowCount));
+	PutULONG(record.args, ulFlags);
+
+	if (g_fReplaying)
+	{
+		ReplayRows(record, lppRows);
+		return record.hr;
+	}
+
+	*lppRows = nullptr;
+	record.hr = m_lpInner->QueryRows(lRowCount, ulFlags, lppRows);
+	if (SUCCEEDED(record.hr)) PutRows(record.data, *lppRows);
+	RecordCall(record);
+	return record.hr;
+}
+
+STDMETHODIMP TracedTable::Abort()
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::ExpandRow(ULONG, LPBYTE, ULONG, ULONG, LPSRowSet FAR*, ULONG FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::CollapseRow(ULONG, LPBYTE, ULONG, ULONG FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::WaitForCompletion(ULONG, ULONG, ULONG FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::GetCollapseState(ULONG, ULONG, LPBYTE, ULONG FAR*, LPBYTE FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedTable::SetCollapseState(ULONG, ULONG, LPBYTE, BOOKMARK FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+/*
+ *  TracedSection
+ */
+class TracedSection : public TracedObject<IProfSect>
+{
+public:
+	TracedSection(LPPROFSECT lpInner, ULONG ulObject) : TracedObject(lpInner, ulObject, IID_IProfSect, &IID_IMAPIProp)
+	{
+	}
+
+	MAPI_IMAPIPROP_METHODS(IMPL)
+	MAPI_IPROFSECT_METHODS(IMPL)
+};
+
+STDMETHODIMP TracedSection::GetLastError(HRESULT, ULONG, LPMAPIERROR FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedSection::SaveChanges(ULONG ulFlags)
+{
+	TraceRecord record = { tcSaveChanges, m_ulObject };
+	PutULONG(record.args, ulFlags);
+
+	if (g_fReplaying)
+	{
+		ReplayCall(record);
+		return record.hr;
+	}
+
+	record.hr = m_lpInner->SaveChanges(ulFlags);
+	RecordCall(record);
+	return record.hr;
+}
+
+STDMETHODIMP TracedSection::GetProps(LPSPropTagArray lpPropTagArray, ULONG ulFlags, ULONG FAR* lpcValues, LPSPropValue FAR* lppPropArray)
+{
+	if (!lpcValues || !lppPropArray) return MAPI_E_INVALID_PARAMETER;
+
+	TraceRecord record = { tcGetProps, m_ulObject };
+	PutTags(record.args, lpPropTagArray);
+	PutULONG(record.args, ulFlags);
+
+	if (g_fReplaying)
+	{
+		ReplayProps(record, lpcValues, lppPropArray);
+		return record.hr;
+	}
+
+	*lpcValues = 0;
+	*lppPropArray = nullptr;
+	record.hr = m_lpInner->GetProps(lpPropTagArray, ulFlags, lpcValues, lppPropArray);
+	if (SUCCEEDED(record.hr)) PutProps(record.data, *lpcValues, *lppPropArray);
+	RecordCall(record);
+	return record.hr;
+}
+
+STDMETHODIMP TracedSection::GetPropList(ULONG, LPSPropTagArray FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedSection::OpenProperty(ULONG, LPCIID, ULONG, ULONG, LPUNKNOWN FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedSection::SetProps(ULONG cValues, LPSPropValue lpPropArray, LPSPropProblemArray FAR* lppProblems)
+{
+	TraceRecord record = { tcSetProps, m_ulObject };
+	PutProps(record.args, cValues, lpPropArray);
+
+	if (g_fReplaying)
+	{
+		// Problems aren't recorded, so a replay reports none
+		if (lppProblems) *lppProblems = nullptr;
+		ReplayCall(record);
+		return record.hr;
+	}
+
+	record.hr = m_lpInner->SetProps(cValues, lpPropArray, lppProblems);
+	RecordCall(record);
+	return record.hr;
+}
+
+STDMETHODIMP TracedSection::DeleteProps(LPSPropTagArray lpPropTagArray, LPSPropProblemArray FAR* lppProblems)
+{
+	TraceRecord record = { tcDeleteProps, m_ulObject };
+	PutTags(record.args, lpPropTagArray);
+
+	if (g_fReplaying)
+	{
+		if (lppProblems) *lppProblems = nullptr;
+		ReplayCall(record);
+		return record.hr;
+	}
+
+	record.hr = m_lpInner->DeleteProps(lpPropTagArray, lppProblems);
+	RecordCall(record);
+	return record.hr;
+}
+
+STDMETHODIMP TracedSection::CopyTo(ULONG, LPCIID, LPSPropTagArray, ULONG_PTR, LPMAPIPROGRESS, LPCIID, LPVOID, ULONG, LPSPropProblemArray FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedSection::CopyProps(LPSPropTagArray, ULONG_PTR, LPMAPIPROGRESS, LPCIID, LPVOID, ULONG, LPSPropProblemArray FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedSection::GetNamesFromIDs(LPSPropTagArray FAR*, LPGUID, ULONG, ULONG FAR*, LPMAPINAMEID FAR* FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedSection::GetIDsFromNames(ULONG, LPMAPINAMEID FAR*, ULONG, LPSPropTagArray FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+/*
+ *  TracedServiceAdmin
+ */
+class TracedServiceAdmin : public TracedObject<IMsgServiceAdmin>
+{
+public:
+	TracedServiceAdmin(LPSERVICEADMIN lpInner, ULONG ulObject) : TracedObject(lpInner, ulObject, IID_IMsgServiceAdmin, nullptr)
+	{
+	}
+
+	MAPI_IMSGSERVICEADMIN_METHODS(IMPL)
+
+private:
+	HRESULT OpenTable(ULONG ulCall, ULONG ulFlags, _Out_ LPMAPITABLE FAR* lppTable);
+};
+
+HRESULT TracedServiceAdmin::OpenTable(ULONG ulCall, ULONG ulFlags, _Out_ LPMAPITABLE FAR* lppTable)
+{
+	TraceRecord record = { ulCall, m_ulObject };
+	PutULONG(record.args, ulFlags);
+
+	LPMAPITABLE lpTable = nullptr;
+	if (g_fReplaying)
+	{
+		ReplayCall(record);
+	}
+	else if (ulCall == tcGetMsgServiceTable)
+	{
+		record.hr = m_lpInner->GetMsgServiceTable(ulFlags, &lpTable);
+	}
+	else
+	{
+		record.hr = m_lpInner->GetProviderTable(ulFlags, &lpTable);
+	}
+
+	OpenResult<TracedTable>(record, lpTable, lppTable);
+	if (!g_fReplaying) RecordCall(record);
+	return record.hr;
+}
+
+STDMETHODIMP TracedServiceAdmin::GetLastError(HRESULT, ULONG, LPMAPIERROR FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedServiceAdmin::GetMsgServiceTable(ULONG ulFlags, LPMAPITABLE FAR* lppTable)
+{
+	if (!lppTable) return MAPI_E_INVALID_PARAMETER;
+	return OpenTable(tcGetMsgServiceTable, ulFlags, lppTable);
+}
+
+STDMETHODIMP TracedServiceAdmin::CreateMsgService(LPTSTR, LPTSTR, ULONG_PTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedServiceAdmin::DeleteMsgService(LPMAPIUID)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedServiceAdmin::CopyMsgService(LPMAPIUID, LPTSTR, LPCIID, LPCIID, LPVOID, ULONG_PTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedServiceAdmin::RenameMsgService(LPMAPIUID, ULONG, LPTSTR)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedServiceAdmin::ConfigureMsgService(LPMAPIUID, ULONG_PTR, ULONG, ULONG, LPSPropValue)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedServiceAdmin::OpenProfileSection(LPMAPIUID lpUID, LPCIID lpInterface, ULONG ulFlags, LPPROFSECT FAR* lppProfSect)
+{
+	if (!lppProfSect) return MAPI_E_INVALID_PARAMETER;
+
+	TraceRecord record = { tcOpenProfileSection, m_ulObject };
+	if (lpUID)
+	{
+		PutBytes(record.args, lpUID, sizeof(MAPIUID));
+	}
+	else
+	{
+		PutULONG(record.args, ulTraceNull);
+	}
+
+	PutULONG(record.args, ulFlags);
+
+	LPPROFSECT lpSection = nullptr;
+	if (g_fReplaying)
+	{
+		ReplayCall(record);
+	}
+	else
+	{
+		record.hr = m_lpInner->OpenProfileSection(lpUID, lpInterface, ulFlags, &lpSection);
+	}
+
+	OpenResult<TracedSection>(record, lpSection, lppProfSect);
+	if (!g_fReplaying) RecordCall(record);
+	return record.hr;
+}
+
+STDMETHODIMP TracedServiceAdmin::MsgServiceTransportOrder(ULONG, LPMAPIUID, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedServiceAdmin::AdminProviders(LPMAPIUID, ULONG, LPPROVIDERADMIN FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedServiceAdmin::SetPrimaryIdentity(LPMAPIUID, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedServiceAdmin::GetProviderTable(ULONG ulFlags, LPMAPITABLE FAR* lppTable)
+{
+	if (!lppTable) return MAPI_E_INVALID_PARAMETER;
+	return OpenTable(tcGetProviderTable, ulFlags, lppTable);
+}
+
+/*
+ *  TracedProfAdmin
+ */
+class TracedProfAdmin : public TracedObject<IProfAdmin>
+{
+public:
+	TracedProfAdmin(LPPROFADMIN lpInner, ULONG ulObject) : TracedObject(lpInner, ulObject, IID_IProfAdmin, nullptr)
+	{
+	}
+
+	MAPI_IPROFADMIN_METHODS(IMPL)
+};
+
+STDMETHODIMP TracedProfAdmin::GetLastError(HRESULT, ULONG, LPMAPIERROR FAR*)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedProfAdmin::GetProfileTable(ULONG ulFlags, LPMAPITABLE FAR* lppTable)
+{
+	if (!lppTable) return MAPI_E_INVALID_PARAMETER;
+
+	TraceRecord record = { tcGetProfileTable, m_ulObject };
+	PutULONG(record.args, ulFlags);
+
+	LPMAPITABLE lpTable = nullptr;
+	if (g_fReplaying)
+	{
+		ReplayCall(record);
+	}
+	else
+	{
+		record.hr = m_lpInner->GetProfileTable(ulFlags, &lpTable);
+	}
+
+	OpenResult<TracedTable>(record, lpTable, lppTable);
+	if (!g_fReplaying) RecordCall(record);
+	return record.hr;
+}
+
+STDMETHODIMP TracedProfAdmin::CreateProfile(LPTSTR, LPTSTR, ULONG_PTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedProfAdmin::DeleteProfile(LPTSTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedProfAdmin::ChangeProfilePassword(LPTSTR, LPTSTR, LPTSTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedProfAdmin::CopyProfile(LPTSTR, LPTSTR, LPTSTR, ULONG_PTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedProfAdmin::RenameProfile(LPTSTR, LPTSTR, LPTSTR, ULONG_PTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedProfAdmin::SetDefaultProfile(LPTSTR, ULONG)
+{
+	return MAPI_E_NO_SUPPORT;
+}
+
+STDMETHODIMP TracedProfAdmin::AdminServices(LPTSTR lpszProfileName, LPTSTR lpszPassword, ULONG_PTR ulUIParam, ULONG ulFlags, LPSERVICEADMIN FAR* lppServiceAdmin)
+{
+	if (!lppServiceAdmin) return MAPI_E_INVALID_PARAMETER;
+
+	// The password is left out of the trace
+	TraceRecord record = { tcAdminServices, m_ulObject };
+	if (ulFlags & MAPI_UNICODE)
+	{
+		PutStringW(record.args, reinterpret_cast<LPCWSTR>(lpszProfileName));
+	}
+	else
+	{
+		PutStringA(record.args, reinterpret_cast<LPCSTR>(lpszProfileName));
+	}
+
+	PutULONG(record.args, ulFlags);
+
+	LPSERVICEADMIN lpServiceAdmin = nullptr;
+	if (g_fReplaying)
+	{
+		ReplayCall(record);
+	}
+	else
+	{
+		record.hr = m_lpInner->AdminServices(lpszProfileName, lpszPassword, ulUIParam, ulFlags, &lpServiceAdmin);
+	}
+
+	OpenResult<TracedServiceAdmin>(record, lpServiceAdmin, lppServiceAdmin);
+	if (!g_fReplaying) RecordCall(record);
+	return record.hr;
+}
+
+/*
+ *  Exports
+ */
+typedef HRESULT (STDAPICALLTYPE *LPHRQUERYALLROWS)(LPMAPITABLE, LPSPropTagArray, LPSRestriction, LPSSortOrderSet, LONG, LPSRowSet FAR*);
+typedef void (STDAPICALLTYPE *LPFREEPROWS)(LPSRowSet);
+
+// What the stubs were bound to when recording started, which the recorder passes calls on to
+static LPMAPIINITIALIZE g_lpfnInnerInitialize = nullptr;
+static LPMAPIUNINITIALIZE g_lpfnInnerUninitialize = nullptr;
+static LPMAPIADMINPROFILES g_lpfnInnerAdminProfiles = nullptr;
+static LPHRQUERYALLROWS g_lpfnInnerQueryAllRows = nullptr;
+static LPMAPIALLOCATEBUFFER g_lpfnInnerAllocateBuffer = nullptr;
+static LPMAPIALLOCATEMORE g_lpfnInnerAllocateMore = nullptr;
+static LPMAPIFREEBUFFER g_lpfnInnerFreeBuffer = nullptr;
+static LPFREEPROWS g_lpfnInnerFreeProws = nullptr;
+
+static HRESULT STDAPICALLTYPE TraceInitialize(LPVOID lpMapiInit)
+{
+	TraceRecord record = { tcInitialize, 0 };
+	if (lpMapiInit)
+	{
+		auto lpInit = static_cast<const MAPIINIT_0*>(lpMapiInit);
+		PutULONG(record.args, lpInit->ulVersion);
+		PutULONG(record.args, lpInit->ulFlags);
+	}
+	else
+	{
+		PutULONG(record.args, ulTraceNull);
+	}
+
+	if (g_fReplaying)
+	{
+		ReplayCall(record);
+		return record.hr;
+	}
+
+	record.hr = g_lpfnInnerInitialize(lpMapiInit);
+	RecordCall(record);
+	return record.hr;
+}
+
+static void STDAPICALLTYPE TraceUninitialize()
+{
+	TraceRecord record = { tcUninitialize, 0 };
+	if (g_fReplaying)
+	{
+		ReplayCall(record);
+		return;
+	}
+
+	g_lpfnInnerUninitialize();
+	record.hr = S_OK;
+	RecordCall(record);
+}
+
+static HRESULT STDMETHODCALLTYPE TraceAdminProfiles(ULONG ulFlags, LPPROFADMIN FAR* lppProfAdmin)
+{
+	if (!lppProfAdmin) return MAPI_E_INVALID_PARAMETER;
+
+	TraceRecord record = { tcAdminProfiles, 0 };
+	PutULONG(record.args, ulFlags);
+
+	LPPROFADMIN lpProfAdmin = nullptr;
+	if (g_fReplaying)
+	{
+		ReplayCall(record);
+	}
+	else
+	{
+		record.hr = g_lpfnInnerAdminProfiles(ulFlags, &lpProfAdmin);
+	}
+
+	OpenResult<TracedProfAdmin>(record, lpProfAdmin, lppProfAdmin);
+	if (!g_fReplaying) RecordCall(record);
+	return record.hr;
+}
+
+// Every table handed out while tracing is a TracedTable
+static HRESULT STDAPICALLTYPE TraceQueryAllRows(
+	LPMAPITABLE lpTable,
+	LPSPropTagArray lpPropTags,
+	LPSRestriction lpRestriction,
+	LPSSortOrderSet lpSortOrderSet,
+	LONG crowsMax,
+	LPSRowSet FAR* lppRows)
+{
+	if (!lpTable || !lppRows) return MAPI_E_INVALID_PARAMETER;
+
+	auto lpTracedTable = static_cast<TracedTable*>(lpTable);
+	TraceRecord record = { tcQueryAllRows, 0 };
+	PutULONG(record.args, lpTracedTable->GetObjectID());
+	PutTags(record.args, lpPropTags);
+	PutRestriction(record.args, lpRestriction);
+	PutSortOrder(record.args, lpSortOrderSet);
+	PutULONG(record.args, static_cast<ULONG>(crowsMax));
+
+	if (g_fReplaying)
+	{
+		ReplayRows(record, lppRows);
+		return record.hr;
+	}
+
+	// The real HrQueryAllRows gets the real table, so the calls it makes on it aren't traced twice
+	*lppRows = nullptr;
+	record.hr = g_lpfnInnerQueryAllRows(lpTracedTable->GetInner(), lpPropTags, lpRestriction, lpSortOrderSet, crowsMax, lppRows);
+	if (SUCCEEDED(record.hr)) PutRows(record.data, *lppRows);
+	RecordCall(record);
+	return record.hr;
+}
+
+static MAPIExport g_traceExports[8];
+
+static void BindTraceExports(
+	LPMAPIALLOCATEBUFFER lpfnAllocateBuffer,
+	LPMAPIALLOCATEMORE lpfnAllocateMore,
+	LPMAPIFREEBUFFER lpfnFreeBuffer,
+	LPFREEPROWS lpfnFreeProws)
+{
+	g_traceExports[0] = { "MAPIInitialize", reinterpret_cast<FARPROC>(static_cast<LPMAPIINITIALIZE>(TraceInitialize)) };
+	g_traceExports[1] = { "MAPIUninitialize", reinterpret_cast<FARPROC>(static_cast<LPMAPIUNINITIALIZE>(TraceUninitialize)) };
+	g_traceExports[2] = { "MAPIAdminProfiles", reinterpret_cast<FARPROC>(static_cast<LPMAPIADMINPROFILES>(TraceAdminProfiles)) };
+	g_traceExports[3] = { "HrQueryAllRows", reinterpret_cast<FARPROC>(static_cast<LPHRQUERYALLROWS>(TraceQueryAllRows)) };
+	g_traceExports[4] = { "MAPIAllocateBuffer", reinterpret_cast<FARPROC>(lpfnAllocateBuffer) };
+	g_traceExports[5] = { "MAPIAllocateMore", reinterpret_cast<FARPROC>(lpfnAllocateMore) };
+	g_traceExports[6] = { "MAPIFreeBuffer", reinterpret_cast<FARPROC>(lpfnFreeBuffer) };
+	g_traceExports[7] = { "FreeProws", reinterpret_cast<FARPROC>(lpfnFreeProws) };
+	SetMAPIExports(g_traceExports, _countof(g_traceExports));
+}
+
+bool StartMAPIRecording(const std::string& traceName)
+{
+	if (g_fTracing) return false;
+
+	// Looked up through whatever the stubs are bound to now, before they're bound to us
+	g_lpfnInnerInitialize = reinterpret_cast<LPMAPIINITIALIZE>(GetMAPIProcAddress(ExpandFunction(MAPIInitialize, 4)));
+	g_lpfnInnerUninitialize = reinterpret_cast<LPMAPIUNINITIALIZE>(GetMAPIProcAddress(ExpandFunction(MAPIUninitialize, 0)));
+	g_lpfnInnerAdminProfiles = reinterpret_cast<LPMAPIADMINPROFILES>(GetMAPIProcAddress(ExpandFunction(MAPIAdminProfiles, 8)));
+	g_lpfnInnerQueryAllRows = reinterpret_cast<LPHRQUERYALLROWS>(GetMAPIProcAddress(ExpandFunction(HrQueryAllRows, 24)));
+	g_lpfnInnerAllocateBuffer = reinterpret_cast<LPMAPIALLOCATEBUFFER>(GetMAPIProcAddress(ExpandFunction(MAPIAllocateBuffer, 8)));
+	g_lpfnInnerAllocateMore = reinterpret_cast<LPMAPIALLOCATEMORE>(GetMAPIProcAddress(ExpandFunction(MAPIAllocateMore, 12)));
+	g_lpfnInnerFreeBuffer = reinterpret_cast<LPMAPIFREEBUFFER>(GetMAPIProcAddress(ExpandFunction(MAPIFreeBuffer, 4)));
+	g_lpfnInnerFreeProws = reinterpret_cast<LPFREEPROWS>(GetMAPIProcAddress(ExpandFunction(FreeProws, 4)));
+	if (!g_lpfnInnerInitialize || !g_lpfnInnerUninitialize || !g_lpfnInnerAdminProfiles || !g_lpfnInnerQueryAllRows ||
+		!g_lpfnInnerAllocateBuffer || !g_lpfnInnerAllocateMore || !g_lpfnInnerFreeBuffer || !g_lpfnInnerFreeProws)
+	{
+		return false;
+	}
+
+	FILE* traceFile = nullptr;
+	if (fopen_s(&traceFile, traceName.c_str(), "wb") || !traceFile) return false;
+	if (fwrite(rgchTraceSignature, sizeof(rgchTraceSignature), 1, traceFile) != 1)
+	{
+		fclose(traceFile);
+		return false;
+	}
+
+	g_lpTraceFile = traceFile;
+	g_ulLastTraceObject = 0;
+	g_fTraceFailed = false;
+	g_fReplaying = false;
+	g_fTracing = true;
+	BindTraceExports(g_lpfnInnerAllocateBuffer, g_lpfnInnerAllocateMore, g_lpfnInnerFreeBuffer, g_lpfnInnerFreeProws);
+	return true;
+}
+
+static bool ReadTrace(const std::string& traceName, _Out_ std::vector<TraceRecord>& records)
+{
+	records.clear();
+
+	FILE* traceFile = nullptr;
+	if (fopen_s(&traceFile, traceName.c_str(), "rb") || !traceFile) return false;
+
+	std::vector<BYTE> buf;
+	BYTE rgb[4096];
+	size_t cb = 0;
+	while ((cb = fread(rgb, 1, sizeof(rgb), traceFile)) > 0)
+	{
+		buf.insert(buf.end(), rgb, rgb + cb);
+	}
+
+	auto fRead = !ferror(traceFile);
+	fclose(traceFile);
+	if (!fRead || buf.size() < sizeof(rgchTraceSignature) ||
+		memcmp(buf.data(), rgchTraceSignature, sizeof(rgchTraceSignature)) != 0)
+	{
+		return false;
+	}
+
+	buf.erase(buf.begin(), buf.begin() + sizeof(rgchTraceSignature));
+	TraceReader reader(buf);
+	while (!reader.IsAtEnd())
+	{
+		TraceRecord record = {};
+		const BYTE* lpbArgs = nullptr;
+		ULONG cbArgs = 0;
+		const BYTE* lpbData = nullptr;
+		ULONG cbData = 0;
+		ULONG ulHr = 0;
+		if (!reader.GetULONG(&record.ulCall) ||
+			!reader.GetULONG(&record.ulObject) ||
+			!reader.GetBytes(&lpbArgs, &cbArgs) ||
+			!reader.GetULONG(&ulHr) ||
+			!reader.GetULONG(&record.ulResultObject) ||
+			!reader.GetBytes(&lpbData, &cbData))
+		{
+			return false;
+		}
+
+		record.hr = static_cast<HRESULT>(ulHr);
+		if (cbArgs) record.args.assign(lpbArgs, lpbArgs + cbArgs);
+		if (cbData) record.data.assign(lpbData, lpbData + cbData);
+		records.push_back(record);
+	}
+
+	return true;
+}
+
+bool StartMAPIReplay(const std::string& traceName)
+{
+	if (g_fTracing) return false;
+
+	std::vector<TraceRecord> records;
+	if (!ReadTrace(traceName, records)) return false;
+
+	g_replayRecords.swap(records);
+	g_iNextReplay = 0;
+	g_fTraceFailed = false;
+	g_fReplaying = true;
+	g_fTracing = true;
+	BindTraceExports(InMemoryAllocateBuffer, InMemoryAllocateMore, InMemoryFreeBuffer, InMemoryFreeProws);
+	return true;
+}
+
+bool StopMAPITrace()
+{
+	if (!g_fTracing) return true;
+
+	SetMAPIExports(NULL, 0);
+
+	auto fOK = !g_fTraceFailed;
+	if (g_lpTraceFile)
+	{
+		if (fclose(g_lpTraceFile) != 0) fOK = false;
+		g_lpTraceFile = nullptr;
+	}
+
+	// Calls recorded but never asked for mean the replay went a different way too
+	if (g_fReplaying && g_iNextReplay != g_replayRecords.size())
+	{
+		wprintf(L"Replay stopped after %u of %u calls in the trace\n",
+			static_cast<unsigned>(g_iNextReplay), static_cast<unsigned>(g_replayRecords.size()));
+		fOK = false;
+	}
+
+	g_replayRecords.clear();
+	g_fReplaying = false;
+	g_fTracing = false;
+	return fOK;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+
+// Recording and replay of the MAPI calls this tool makes. Recording puts itself between the stubs
+// and whatever they are bound to, MAPI or the in-memory store, and writes every call to a trace:
+// which export or method was called and on what object, its arguments, the HRESULT it returned
+// and any property values or rows it handed back. Replay binds the stubs to the trace instead and
+// serves each call back in order, so a profile captured on one machine can be repaired and timed
+// on another with no MAPI installed.
+//
+// The trace is a four byte signature followed by one record per call:
+//   ULONG call           - which export or method, a TraceCallID
+//   ULONG object         - the object it was called on, 0 for an export
+//   ULONG cbArgs, args   - the arguments
+//   HRESULT hr           - what it returned
+//   ULONG resultObject   - the object it returned, 0 if none
+//   ULONG cbData, data   - the property values or rows it returned
+// Objects are numbered in the order they're created, so a replay making the same calls gets the
+// same numbers. Strings are stored as 8 bit or UTF-16 code units so traces move between platforms.
+// Passwords are never recorded.
+//
+// Only the calls this tool makes are traced. Other methods fail with MAPI_E_NO_SUPPORT while
+// recording as well as in replay, so whatever worked while recording can be replayed.
+// Neither mode is thread safe.
+
+// Binds the stubs to a recorder in front of their current binding. Call before MAPIInitialize.
+bool StartMAPIRecording(const std::string& traceName);
+
+// Binds the stubs to a replay of the trace. Call before MAPIInitialize.
+bool StartMAPIReplay(const std::string& traceName);
+
+// Unbinds the stubs and closes the trace. Returns false if the trace couldn't be written, or the
+// replay was asked for a call other than the next one recorded.
+bool StopMAPITrace();
@@ -0,0 +1,98 @@
+#include "stdafx.h"
+#include "OfflineProfiles.h"
+#include <MAPITags.h>
+#include <stdio.h>
+#include "HexCodec.h"
+
+std::string PropTagValueName(ULONG ulPropTag)
+{
+	char szName[9] = {};
+	sprintf_s(szName, _countof(szName), "%04x%04x", PROP_TYPE(ulPropTag), PROP_ID(ulPropTag));
+	return szName;
+}
+
+std::string SectionKeyName(_In_ const MAPIUID& uid)
+{
+	SBinary bin = { sizeof(MAPIUID), const_cast<LPBYTE>(uid.ab) };
+	return BinToHexStringA(&bin);
+}
+
+std::vector<OfflineProfile> GetOfflineProfiles(const RegfHive& hive)
+{
+	std::vector<OfflineProfile> profiles;
+	for (const auto szRoot : rgszProfileRoots)
+	{
+		auto rootKey = hive.OpenKey(hive.GetRootKey(), szRoot);
+		if (rootKey == hiveCellNone) continue;
+
+		for (const auto profileKey : hive.GetSubkeys(rootKey))
+		{
+			profiles.push_back({ hive.GetKeyName(profileKey), profileKey });
+		}
+	}
+
+	return profiles;
+}
+
+HiveCell GetOfflineBinaryProp(const RegfHive& hive, HiveCell sectionKey, ULONG ulPropTag, _Out_ SBinary* lpBin)
+{
+	lpBin->cb = 0;
+	lpBin->lpb = nullptr;
+
+	auto value = hive.FindValue(sectionKey, PropTagValueName(ulPropTag));
+	if (value == hiveCellNone) return hiveCellNone;
+
+	const BYTE* lpb = nullptr;
+	ULONG cb = 0;
+	if (!hive.GetValueData(value, &lpb, &cb, nullptr)) return hiveCellNone;
+
+	lpBin->cb = cb;
+	lpBin->lpb = const_cast<LPBYTE>(lpb);
+	return value;
+}
+
+bool IsServiceName(const SBinary& bin, bool fUnicode, const std::string& serviceName)
+{
+	auto cbChar = fUnicode ? 2 : 1;
+	if (bin.cb != (serviceName.size() + 1) * cbChar) return false;
+
+	for (size_t i = 0; i < serviceName.size(); i++)
+	{
+		if (bin.lpb[i * cbChar] != static_cast<BYTE>(serviceName[i])) return false;
+		if (fUnicode && bin.lpb[i * cbChar + 1] != 0) return false;
+	}
+
+	return true;
+}
+
+HiveCell FindOfflineServiceSection(const RegfHive& hive, HiveCell profileKey, const std::string& serviceName)
+{
+	for (const auto sectionKey : hive.GetSubkeys(profileKey))
+	{
+		SBinary name = {};
+		auto fUnicode = false;
+		if (GetOfflineBinaryProp(hive, sectionKey, PR_SERVICE_NAME_A, &name) == hiveCellNone)
+		{
+			if (GetOfflineBinaryProp(hive, sectionKey, PR_SERVICE_NAME_W, &name) == hiveCellNone) continue;
+			fUnicode = true;
+		}
+
+		if (!IsServiceName(name, fUnicode, serviceName)) continue;
+
+		// Provider sections can carry the service name too. The service's own section is
+		// the one named for its PR_SERVICE_UID.
+		SBinary uid = {};
+		if (GetOfflineBinaryProp(hive, sectionKey, PR_SERVICE_UID, &uid) != hiveCellNone)
+		{
+			if (uid.cb != sizeof(MAPIUID) ||
+				!RegfHive::IsSameName(SectionKeyName(*reinterpret_cast<LPMAPIUID>(uid.lpb)), hive.GetKeyName(sectionKey)))
+			{
+				continue;
+			}
+		}
+
+		return sectionKey;
+	}
+
+	return hiveCellNone;
+}
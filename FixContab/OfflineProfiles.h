@@ -0,0 +1,41 @@
+#pragma once
+#include <MAPIDefS.h>
+#include <string>
+#include <vector>
+#include "RegfHive.h"
+
+// MAPI profiles as Outlook stores them in a user's hive. Each profile is a key holding one
+// subkey per profile section, named for the section's MAPIUID in hex. Each property of a
+// section is a REG_BINARY value named for its type and ID, so PR_AB_PROVIDERS is "01023d01".
+
+// Where profiles live, relative to the root of a user's hive, newest Outlook first
+const char* const rgszProfileRoots[] = {
+	"Software\\Microsoft\\Office\\16.0\\Outlook\\Profiles",
+	"Software\\Microsoft\\Office\\15.0\\Outlook\\Profiles",
+	"Software\\Microsoft\\Windows NT\\CurrentVersion\\Windows Messaging Subsystem\\Profiles",
+};
+
+struct OfflineProfile
+{
+	std::string name;
+	HiveCell key;
+};
+
+// Registry value name for a property, such as "01023d01" for PR_AB_PROVIDERS
+std::string PropTagValueName(ULONG ulPropTag);
+
+// Registry key name for a profile section, such as "9207f3e0a3b11019908b08002b2a56c2"
+std::string SectionKeyName(_In_ const MAPIUID& uid);
+
+// True if bin is a PR_SERVICE_NAME value naming serviceName. String properties are stored with
+// their terminator, PT_STRING8 as bytes and PT_UNICODE as UTF-16LE.
+bool IsServiceName(const SBinary& bin, bool fUnicode, const std::string& serviceName);
+
+// Every profile under each of the Outlook and Windows Messaging profile roots in the hive
+std::vector<OfflineProfile> GetOfflineProfiles(const RegfHive& hive);
+
+// The section of the message service whose PR_SERVICE_NAME is serviceName, or hiveCellNone
+HiveCell FindOfflineServiceSection(const RegfHive& hive, HiveCell profileKey, const std::string& serviceName);
+
+// Finds the value for ulPropTag in a section and points lpBin at its data in the hive
+HiveCell GetOfflineBinaryProp(const RegfHive& hive, HiveCell sectionKey, ULONG ulPropTag, _Out_ SBinary* lpBin);
@@ -0,0 +1,185 @@
+#include "stdafx.h"
+#include "ProviderJournal.h"
+#include <MAPITags.h>
+#include <io.h>
+#include <string.h>
+
+const char rgchJournalSignature[4] = { 'F', 'C', 'J', '2' };
+const char rgchJournalSignatureV1[4] = { 'F', 'C', 'J', '1' };
+
+FILE* OpenJournal(const std::string& journalName)
+{
+	FILE* journal = nullptr;
+	if (fopen_s(&journal, journalName.c_str(), "a+b") || !journal) return nullptr;
+
+	// Writes always go to the end in append mode, so we're free to seek back and check the signature.
+	// Older journals are only read, never appended to.
+	fseek(journal, 0, SEEK_END);
+	if (ftell(journal) == 0)
+	{
+		if (fwrite(rgchJournalSignature, sizeof(rgchJournalSignature), 1, journal) == 1 && fflush(journal) == 0)
+		{
+			return journal;
+		}
+	}
+	else
+	{
+		char rgchSignature[sizeof(rgchJournalSignature)] = {};
+		fseek(journal, 0, SEEK_SET);
+		if (fread(rgchSignature, sizeof(rgchSignature), 1, journal) == 1 &&
+			memcmp(rgchSignature, rgchJournalSignature, sizeof(rgchSignature)) == 0)
+		{
+			fseek(journal, 0, SEEK_END);
+			return journal;
+		}
+	}
+
+	fclose(journal);
+	return nullptr;
+}
+
+static bool WriteString(FILE* journal, const std::string& str)
+{
+	if (str.size() > 0xFFFF) return false;
+
+	auto cb = static_cast<WORD>(str.size());
+	if (fwrite(&cb, sizeof(cb), 1, journal) != 1) return false;
+	return !cb || fwrite(str.data(), cb, 1, journal) == 1;
+}
+
+static bool WriteValue(FILE* journal, const std::vector<BYTE>& value)
+{
+	auto cb = static_cast<ULONG>(value.size());
+	if (fwrite(&cb, sizeof(cb), 1, journal) != 1) return false;
+	return !cb || fwrite(value.data(), cb, 1, journal) == 1;
+}
+
+bool AppendJournalEntry(_In_ FILE* journal, const JournalEntry& entry)
+{
+	auto fWritten = WriteString(journal, entry.source) &&
+		WriteString(journal, entry.profileName) &&
+		fwrite(&entry.ulPropTag, sizeof(entry.ulPropTag), 1, journal) == 1 &&
+		WriteValue(journal, entry.oldValue) &&
+		WriteValue(journal, entry.newValue);
+
+	// The change is only made once its record is safely on disk
+	return fflush(journal) == 0 && fWritten && _commit(_fileno(journal)) == 0;
+}
+
+// Limit on a single value, so a corrupt length can't have us allocate gigabytes
+const ULONG cbMaxJournalValue = 0x100000;
+
+static bool ReadString(FILE* journal, std::string& str)
+{
+	WORD cb = 0;
+	if (fread(&cb, sizeof(cb), 1, journal) != 1) return false;
+
+	str.resize(cb);
+	return !cb || fread(&str[0], cb, 1, journal) == 1;
+}
+
+static bool ReadValue(FILE* journal, ULONG cb, std::vector<BYTE>& value)
+{
+	if (cb > cbMaxJournalValue) return false;
+
+	value.resize(cb);
+	return !cb || fread(value.data(), cb, 1, journal) == 1;
+}
+
+static bool ReadValue(FILE* journal, std::vector<BYTE>& value)
+{
+	ULONG cb = 0;
+	return fread(&cb, sizeof(cb), 1, journal) == 1 && ReadValue(journal, cb, value);
+}
+
+bool ReadJournal(const std::string& journalName, std::vector<JournalEntry>& entries, _Out_opt_ bool* lpfTruncated)
+{
+	if (lpfTruncated) *lpfTruncated = false;
+
+	FILE* journal = nullptr;
+	if (fopen_s(&journal, journalName.c_str(), "rb") || !journal) return false;
+
+	char rgchSignature[sizeof(rgchJournalSignature)] = {};
+	auto fRead = fread(rgchSignature, sizeof(rgchSignature), 1, journal) == 1;
+	auto fV1 = fRead && memcmp(rgchSignature, rgchJournalSignatureV1, sizeof(rgchSignature)) == 0;
+	if (!fRead || (!fV1 && memcmp(rgchSignature, rgchJournalSignature, sizeof(rgchSignature)) != 0))
+	{
+		fclose(journal);
+		return false;
+	}
+
+	for (;;)
+	{
+		// Running out of data right at a record boundary is the normal end of the journal
+		auto ch = fgetc(journal);
+		if (ch == EOF) break;
+		ungetc(ch, journal);
+
+		JournalEntry entry;
+		entry.ulPropTag = PR_AB_PROVIDERS;
+		fRead = ReadString(journal, entry.source) && ReadString(journal, entry.profileName);
+		if (fRead && fV1)
+		{
+			ULONG cb = 0;
+			fRead = fread(&cb, sizeof(cb), 1, journal) == 1 &&
+				ReadValue(journal, cb, entry.oldValue) &&
+				ReadValue(journal, cb, entry.newValue);
+		}
+		else if (fRead)
+		{
+			fRead = fread(&entry.ulPropTag, sizeof(entry.ulPropTag), 1, journal) == 1 &&
+				ReadValue(journal, entry.oldValue) &&
+				ReadValue(journal, entry.newValue);
+		}
+
+		if (!fRead)
+		{
+			if (lpfTruncated) *lpfTruncated = true;
+			break;
+		}
+
+		entries.push_back(entry);
+	}
+
+	fclose(journal);
+	return true;
+}
+
+std::vector<BYTE> FlattenBinaryArray(_In_ const SBinaryArray& array)
+{
+	std::vector<BYTE> flat;
+	for (ULONG i = 0; i < array.cValues; i++)
+	{
+		const auto& value = array.lpbin[i];
+		auto lpcb = reinterpret_cast<const BYTE*>(&value.cb);
+		flat.insert(flat.end(), lpcb, lpcb + sizeof(value.cb));
+		if (value.cb) flat.insert(flat.end(), value.lpb, value.lpb + value.cb);
+	}
+
+	return flat;
+}
+
+bool UnflattenBinaryArray(const std::vector<BYTE>& flat, _Out_ std::vector<SBinary>& values)
+{
+	values.clear();
+	size_t ib = 0;
+	while (ib < flat.size())
+	{
+		ULONG cb = 0;
+		if (flat.size() - ib < sizeof(cb)) return false;
+		memcpy(&cb, flat.data() + ib, sizeof(cb));
+		ib += sizeof(cb);
+
+		if (flat.size() - ib < cb) return false;
+		values.push_back({ cb, const_cast<LPBYTE>(flat.data() + ib) });
+		ib += cb;
+	}
+
+	return true;
+}
+
+bool IsUnchangedSinceJournal(_In_ const SBinary& bin, const JournalEntry& entry)
+{
+	if (bin.cb != entry.newValue.size()) return false;
+	return !bin.cb || (bin.lpb && memcmp(bin.lpb, entry.newValue.data(), bin.cb) == 0);
+}
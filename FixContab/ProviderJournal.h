@@ -0,0 +1,48 @@
+#pragma once
+#include <MAPIDefS.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// A journal of every provider list we've rewritten, so a run can be undone with --rollback.
+// The file is a four byte signature followed by one record per change:
+//   WORD cbSource, source   - full path of the hive the profile is in, empty for a MAPI profile
+//   WORD cbProfile, profile - profile name
+//   ULONG ulPropTag         - the property changed
+//   ULONG cbOld, old        - the value before
+//   ULONG cbNew, new        - the value after
+// Multi-valued properties are stored as FlattenBinaryArray gives them. Journals written before
+// policies existed have the signature FCJ1, only hold PR_AB_PROVIDERS and have no tag, and a
+// single size shared by the old and new value. They can still be read.
+// Records are appended and flushed one at a time, before the change is written, so a run that
+// dies part way still leaves every change it made in the journal.
+
+struct JournalEntry
+{
+	std::string source;
+	std::string profileName;
+	ULONG ulPropTag;
+	std::vector<BYTE> oldValue;
+	std::vector<BYTE> newValue;
+};
+
+// Opens journalName for appending, creating it if needed. Returns nullptr if it can't be
+// opened or holds something other than a journal. Close with fclose.
+FILE* OpenJournal(const std::string& journalName);
+
+// Appends a record and flushes it to disk
+bool AppendJournalEntry(_In_ FILE* journal, const JournalEntry& entry);
+
+// Reads every complete record, oldest first. A partial record at the end, left by a run
+// that died while appending, is reported through lpfTruncated and ignored.
+bool ReadJournal(const std::string& journalName, std::vector<JournalEntry>& entries, _Out_opt_ bool* lpfTruncated);
+
+// Packs a PT_MV_BINARY value into a single buffer, each value preceded by its ULONG size
+std::vector<BYTE> FlattenBinaryArray(_In_ const SBinaryArray& array);
+
+// Splits a buffer from FlattenBinaryArray into values pointing into it. Returns false if it's malformed.
+bool UnflattenBinaryArray(const std::vector<BYTE>& flat, _Out_ std::vector<SBinary>& values);
+
+// True if bin still holds the value the entry wrote, so nothing else has changed it since
+// and it is safe to put the old value back
+bool IsUnchangedSinceJournal(_In_ const SBinary& bin, const JournalEntry& entry);
@@ -0,0 +1,58 @@
+#include "stdafx.h"
+#include "ProviderOrder.h"
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
+
+bool IsSameMAPIUID(_In_ const MAPIUID& uid1, _In_ const MAPIUID& uid2)
+{
+#if defined(_M_X64) || defined(_M_IX86)
+	auto xmm1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uid1.ab));
+	auto xmm2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uid2.ab));
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(xmm1, xmm2)) == 0xFFFF;
+#else
+	return memcmp(uid1.ab, uid2.ab, sizeof(MAPIUID)) == 0;
+#endif
+}
+
+bool IsValidProviderList(_In_opt_ const SBinary* lpBin)
+{
+	if (!lpBin || !lpBin->cb || !lpBin->lpb) return false;
+	return lpBin->cb % sizeof(MAPIUID) == 0;
+}
+
+ULONG CountProviderUIDs(_In_opt_ const SBinary* lpBin)
+{
+	if (!IsValidProviderList(lpBin)) return 0;
+	return lpBin->cb / sizeof(MAPIUID);
+}
+
+ULONG FindProviderUID(_In_ const SBinary& bin, _In_ const MAPIUID& uid)
+{
+	auto cUIDs = CountProviderUIDs(&bin);
+	auto lpUIDs = reinterpret_cast<const MAPIUID*>(bin.lpb);
+	for (ULONG i = 0; i < cUIDs; i++)
+	{
+		if (IsSameMAPIUID(lpUIDs[i], uid)) return i;
+	}
+
+	return ulProviderNotFound;
+}
+
+ReorderResult MoveProviderToFront(_Inout_ SBinary& bin, _In_ const MAPIUID& uid)
+{
+	if (!IsValidProviderList(&bin)) return ReorderResult::Invalid;
+
+	auto iFound = FindProviderUID(bin, uid);
+	if (iFound == ulProviderNotFound) return ReorderResult::NotFound;
+	if (iFound == 0) return ReorderResult::AlreadyFirst;
+
+	// uid may point into bin, so take a copy before shifting the entries ahead of it
+	auto found = reinterpret_cast<const MAPIUID*>(bin.lpb)[iFound];
+	memmove(bin.lpb + sizeof(MAPIUID), bin.lpb, iFound * sizeof(MAPIUID));
+	memcpy(bin.lpb, found.ab, sizeof(MAPIUID));
+
+	return ReorderResult::Moved;
+}
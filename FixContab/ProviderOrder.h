@@ -0,0 +1,40 @@
+#pragma once
+#include <MAPIDefS.h>
+
+// Provider lists such as PR_AB_PROVIDERS are packed arrays of 16 byte MAPIUIDs.
+// These helpers work on the SBinary directly, so a list can be searched and
+// reordered in place without converting it to a hex string and back.
+
+// Profile section holding the profile wide provider lists
+#define PS_MAPI_PROVIDERS_INIT		{ 0x92,0x07,0xF3,0xE0, \
+									  0xA3,0xB1,0x10,0x19, \
+									  0x90,0x8B,0x08,0x00, \
+									  0x2B,0x2A,0x56,0xC2 }
+const MAPIUID muidProviderSection = PS_MAPI_PROVIDERS_INIT;
+
+enum class ReorderResult
+{
+	Invalid, // Not a whole number of MAPIUIDs
+	NotFound,
+	AlreadyFirst,
+	Moved,
+};
+
+// Sentinel returned by FindProviderUID when the UID isn't in the list
+const ULONG ulProviderNotFound = static_cast<ULONG>(-1);
+
+// IsEqualMAPIUID, but compares the two MAPIUIDs as single 128 bit values
+bool IsSameMAPIUID(_In_ const MAPIUID& uid1, _In_ const MAPIUID& uid2);
+
+// Returns true if lpBin holds a whole number of MAPIUIDs
+bool IsValidProviderList(_In_opt_ const SBinary* lpBin);
+
+// Number of MAPIUIDs in lpBin, or 0 if it isn't a valid provider list
+ULONG CountProviderUIDs(_In_opt_ const SBinary* lpBin);
+
+// Index of uid in the provider list, or ulProviderNotFound
+ULONG FindProviderUID(_In_ const SBinary& bin, _In_ const MAPIUID& uid);
+
+// Rotates uid to the front of the provider list, keeping the relative order of the
+// other entries. The list is modified in place and nothing is allocated.
+ReorderResult MoveProviderToFront(_Inout_ SBinary& bin, _In_ const MAPIUID& uid);
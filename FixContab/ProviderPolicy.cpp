@@ -0,0 +1,198 @@
+#include "stdafx.h"
+#include "ProviderPolicy.h"
+#include "ProviderOrder.h"
+#include <MAPITags.h>
+#include <algorithm>
+#include <sstream>
+#include <string.h>
+
+const ULONG providerListTags[cProviderLists] = { PR_STORE_PROVIDERS, PR_TRANSPORT_PROVIDERS, PR_AB_PROVIDERS, PR_AB_SEARCH_PATH };
+
+// Names used for each ProviderList in a policy file
+const char* const rgszProviderListNames[cProviderLists] = { "store", "transport", "ab", "search" };
+
+// Rank given to entries no first rule matched, which puts them after every entry one did
+const ULONG ulUnranked = static_cast<ULONG>(-1);
+
+LPCSTR ProviderListName(ProviderList list)
+{
+	return list < cProviderLists ? rgszProviderListNames[list] : "";
+}
+
+static std::string ToUpper(std::string str)
+{
+	for (auto& ch : str)
+	{
+		if (ch >= 'a' && ch <= 'z') ch -= 'a' - 'A';
+	}
+
+	return str;
+}
+
+ProviderPolicy::ProviderPolicy()
+{
+	for (auto& rules : m_lists)
+	{
+		rules.fDedupe = false;
+		rules.fDropOrphans = false;
+	}
+}
+
+bool ProviderPolicy::AddRule(const std::string& line)
+{
+	std::istringstream tokens(line);
+	std::string listName;
+	std::string rule;
+	std::string serviceName;
+	std::string extra;
+	tokens >> listName >> rule >> serviceName >> extra;
+	if (!extra.empty()) return false;
+
+	auto iList = std::find_if(std::begin(rgszProviderListNames), std::end(rgszProviderListNames),
+		[&](const char* szName) { return listName == szName; }) - std::begin(rgszProviderListNames);
+	if (iList == cProviderLists) return false;
+
+	// Nothing maps a search path entry to a service, so only the rule that doesn't need to is allowed
+	if (iList == plSearchPath && rule != "dedupe") return false;
+
+	auto& rules = m_lists[iList];
+	if (rule == "first" && !serviceName.empty())
+	{
+		rules.firstServices.push_back(ToUpper(serviceName));
+	}
+	else if (rule == "dedupe" && serviceName.empty())
+	{
+		rules.fDedupe = true;
+	}
+	else if (rule == "drop-orphans" && serviceName.empty())
+	{
+		rules.fDropOrphans = true;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool ProviderPolicy::Compile(_In_ FILE* file, _Out_ ULONG* lpulLine)
+{
+	*lpulLine = 0;
+	char szLine[1024];
+	while (fgets(szLine, _countof(szLine), file))
+	{
+		(*lpulLine)++;
+		auto szRule = szLine + strspn(szLine, " \t\r\n");
+		if (!*szRule || *szRule == '#') continue;
+
+		if (!AddRule(szRule)) return false;
+	}
+
+	return true;
+}
+
+bool ProviderPolicy::IsEmpty() const
+{
+	for (const auto& rules : m_lists)
+	{
+		if (!rules.firstServices.empty() || rules.fDedupe || rules.fDropOrphans) return false;
+	}
+
+	return true;
+}
+
+void ProviderPolicy::ApplyToList(
+	const ListRules& rules,
+	const std::vector<SBinary>& entries,
+	const std::vector<ProfileProvider>& providers,
+	_Out_ std::vector<SBinary>& ordered) const
+{
+	// Ranks are worked out per provider rather than per entry, so service names are compared
+	// once for each provider no matter how long the list is
+	std::vector<ULONG> providerRanks(providers.size(), ulUnranked);
+	for (size_t i = 0; i < providers.size(); i++)
+	{
+		auto serviceName = ToUpper(providers[i].serviceName);
+		auto lpFirst = std::find(rules.firstServices.begin(), rules.firstServices.end(), serviceName);
+		if (lpFirst != rules.firstServices.end())
+		{
+			providerRanks[i] = static_cast<ULONG>(lpFirst - rules.firstServices.begin());
+		}
+	}
+
+	// With no providers to go by, every entry would look orphaned
+	auto fDropOrphans = rules.fDropOrphans && !providers.empty();
+
+	std::vector<std::pair<ULONG, SBinary>> ranked;
+	ranked.reserve(entries.size());
+	for (const auto& entry : entries)
+	{
+		auto iProvider = providers.size();
+		// Only provider UID lists hold bare UIDs. Search path entries never match a provider.
+		if (entry.cb == sizeof(MAPIUID))
+		{
+			auto& uid = *reinterpret_cast<const MAPIUID*>(entry.lpb);
+			iProvider = std::find_if(providers.begin(), providers.end(),
+				[&](const ProfileProvider& provider) { return IsSameMAPIUID(provider.uid, uid); }) - providers.begin();
+		}
+
+		if (fDropOrphans && iProvider == providers.size()) continue;
+
+		if (rules.fDedupe &&
+			std::any_of(ranked.begin(), ranked.end(), [&](const std::pair<ULONG, SBinary>& kept) {
+				return kept.second.cb == entry.cb && memcmp(kept.second.lpb, entry.lpb, entry.cb) == 0; }))
+		{
+			continue;
+		}
+
+		ranked.push_back({ iProvider == providers.size() ? ulUnranked : providerRanks[iProvider], entry });
+	}
+
+	std::stable_sort(ranked.begin(), ranked.end(),
+		[](const std::pair<ULONG, SBinary>& entry1, const std::pair<ULONG, SBinary>& entry2) { return entry1.first < entry2.first; });
+
+	ordered.clear();
+	for (const auto& entry : ranked)
+	{
+		ordered.push_back(entry.second);
+	}
+}
+
+void ProviderPolicy::Apply(const ProviderLists& lists, const std::vector<ProfileProvider>& providers, _Out_ PolicyResult& result) const
+{
+	std::vector<SBinary> entries;
+	for (ULONG iList = 0; iList < cProviderLists; iList++)
+	{
+		result.fChanged[iList] = false;
+		result.entries[iList].clear();
+
+		const auto& rules = m_lists[iList];
+		if (rules.firstServices.empty() && !rules.fDedupe && !rules.fDropOrphans) continue;
+
+		// Split the list into entries pointing into the caller's data
+		entries.clear();
+		if (iList == plSearchPath)
+		{
+			if (!lists.lpSearchPath) continue;
+			entries.assign(lists.lpSearchPath->lpbin, lists.lpSearchPath->lpbin + lists.lpSearchPath->cValues);
+		}
+		else
+		{
+			auto lpList = lists.lpUIDLists[iList];
+			if (!IsValidProviderList(lpList)) continue;
+			for (ULONG i = 0; i < CountProviderUIDs(lpList); i++)
+			{
+				entries.push_back({ sizeof(MAPIUID), lpList->lpb + i * sizeof(MAPIUID) });
+			}
+		}
+
+		ApplyToList(rules, entries, providers, result.entries[iList]);
+
+		// Entries are never copied, so comparing where they point is enough to spot a change
+		result.fChanged[iList] = result.entries[iList].size() != entries.size() ||
+			!std::equal(entries.begin(), entries.end(), result.entries[iList].begin(),
+				[](const SBinary& entry1, const SBinary& entry2) { return entry1.lpb == entry2.lpb; });
+		if (!result.fChanged[iList]) result.entries[iList].clear();
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <MAPIDefS.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// Ordering rules for a profile's provider lists, read from a policy file such as:
+//   # list     rule          service
+//   ab         first         CONTAB
+//   store      dedupe
+//   search     dedupe
+//   transport  drop-orphans
+// store, transport and ab are PR_STORE_PROVIDERS, PR_TRANSPORT_PROVIDERS and PR_AB_PROVIDERS, which
+// are packed arrays of provider UIDs. search is PR_AB_SEARCH_PATH, a list of container entry IDs.
+// The rules are:
+//   first service - moves the service's entries ahead of the rest. Earlier first rules win.
+//   dedupe        - keeps only the first copy of each entry
+//   drop-orphans  - drops entries whose provider isn't in the profile's provider table. Does
+//                   nothing if the table is empty, since then every entry would look orphaned.
+// A container's entry ID holds the UID its provider registered, not the PR_PROVIDER_UID the
+// provider table lists, so search path entries can't be tied to a service. search only takes dedupe.
+// A policy is compiled once per run. Applying it to a profile walks each list once.
+
+enum ProviderList
+{
+	plStore,
+	plTransport,
+	plAB,
+	plSearchPath,
+	cProviderLists,
+};
+
+// Property holding each ProviderList
+extern const ULONG providerListTags[cProviderLists];
+
+// Name of the list in a policy file, such as "ab"
+LPCSTR ProviderListName(ProviderList list);
+
+// A row of the profile's provider table
+struct ProfileProvider
+{
+	MAPIUID uid;
+	std::string serviceName;
+};
+
+// A profile's lists as read from its providers section. Lists it doesn't have are nullptr.
+struct ProviderLists
+{
+	const SBinary* lpUIDLists[plSearchPath];
+	const SBinaryArray* lpSearchPath;
+};
+
+struct PolicyResult
+{
+	bool fChanged[cProviderLists];
+
+	// Entries of each changed list in their new order, pointing into the lists the policy was applied to
+	std::vector<SBinary> entries[cProviderLists];
+};
+
+class ProviderPolicy
+{
+public:
+	ProviderPolicy();
+
+	// Compiles the rules in file, one per line. Blank lines and lines starting with # are skipped.
+	// On failure lpulLine gets the number of the line that couldn't be parsed.
+	bool Compile(_In_ FILE* file, _Out_ ULONG* lpulLine);
+
+	bool IsEmpty() const;
+
+	void Apply(const ProviderLists& lists, const std::vector<ProfileProvider>& providers, _Out_ PolicyResult& result) const;
+
+private:
+	struct ListRules
+	{
+		// Upper cased, in priority order
+		std::vector<std::string> firstServices;
+		bool fDedupe;
+		bool fDropOrphans;
+	};
+
+	bool AddRule(const std::string& line);
+	void ApplyToList(const ListRules& rules, const std::vector<SBinary>& entries, const std::vector<ProfileProvider>& providers, _Out_ std::vector<SBinary>& ordered) const;
+
+	ListRules m_lists[cProviderLists];
+};
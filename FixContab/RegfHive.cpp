@@ -0,0 +1,469 @@
+#include "stdafx.h"
+#include "RegfHive.h"
+#include <string.h>
+
+// Base block, the first 4k of the file
+const ULONG cbBaseBlock = 0x1000;
+const ULONG ibPrimarySequence = 0x04;
+const ULONG ibSecondarySequence = 0x08;
+const ULONG ibTimestamp = 0x0C;
+const ULONG ibMajorVersion = 0x14;
+const ULONG ibFileType = 0x1C;
+const ULONG ibFileFormat = 0x20;
+const ULONG ibRootCell = 0x24;
+const ULONG ibBinsSize = 0x28;
+const ULONG ibChecksum = 0x1FC;
+
+// Key node (nk) cell
+const ULONG ibKeyFlags = 2;
+const ULONG ibKeyTimestamp = 4;
+const ULONG ibSubkeyCount = 20;
+const ULONG ibSubkeyList = 28;
+const ULONG ibValueCount = 36;
+const ULONG ibValueList = 40;
+const ULONG ibKeyNameLength = 72;
+const ULONG ibKeyName = 76;
+const WORD KEY_COMP_NAME = 0x0020; // Name is stored one byte per character
+
+// Value (vk) cell
+const ULONG ibValueNameLength = 2;
+const ULONG ibDataSize = 4;
+const ULONG ibDataOffset = 8;
+const ULONG ibDataType = 12;
+const ULONG ibValueFlags = 16;
+const ULONG ibValueName = 20;
+const WORD VALUE_COMP_NAME = 0x0001;
+const ULONG DATA_IN_OFFSET = 0x80000000; // Data of 4 bytes or less lives in the data offset field
+
+static WORD ReadWord(const BYTE* lpb)
+{
+	WORD w = 0;
+	memcpy(&w, lpb, sizeof(w));
+	return w;
+}
+
+static ULONG ReadDword(const BYTE* lpb)
+{
+	ULONG ul = 0;
+	memcpy(&ul, lpb, sizeof(ul));
+	return ul;
+}
+
+static void WriteDword(BYTE* lpb, ULONG ul)
+{
+	memcpy(lpb, &ul, sizeof(ul));
+}
+
+// XOR of the first 127 dwords of the base block. 0 and -1 are reserved.
+static ULONG BaseBlockChecksum(const BYTE* lpbBase)
+{
+	ULONG ulChecksum = 0;
+	for (ULONG ib = 0; ib < ibChecksum; ib += sizeof(ULONG))
+	{
+		ulChecksum ^= ReadDword(lpbBase + ib);
+	}
+
+	if (ulChecksum == 0xFFFFFFFF) return 0xFFFFFFFE;
+	if (ulChecksum == 0) return 1;
+	return ulChecksum;
+}
+
+static void AppendUtf8(std::string& sz, ULONG ulChar)
+{
+	if (ulChar < 0x80)
+	{
+		sz += static_cast<char>(ulChar);
+	}
+	else if (ulChar < 0x800)
+	{
+		sz += static_cast<char>(0xC0 | (ulChar >> 6));
+		sz += static_cast<char>(0x80 | (ulChar & 0x3F));
+	}
+	else if (ulChar < 0x10000)
+	{
+		sz += static_cast<char>(0xE0 | (ulChar >> 12));
+		sz += static_cast<char>(0x80 | ((ulChar >> 6) & 0x3F));
+		sz += static_cast<char>(0x80 | (ulChar & 0x3F));
+	}
+	else
+	{
+		sz += static_cast<char>(0xF0 | (ulChar >> 18));
+		sz += static_cast<char>(0x80 | ((ulChar >> 12) & 0x3F));
+		sz += static_cast<char>(0x80 | ((ulChar >> 6) & 0x3F));
+		sz += static_cast<char>(0x80 | (ulChar & 0x3F));
+	}
+}
+
+// Key and value names are either Latin-1 or UTF-16LE. Either way we hand back UTF-8.
+static std::string DecodeName(const BYTE* lpb, ULONG cb, bool fCompressed)
+{
+	std::string name;
+	if (fCompressed)
+	{
+		for (ULONG i = 0; i < cb; i++) AppendUtf8(name, lpb[i]);
+		return name;
+	}
+
+	for (ULONG i = 0; i + 1 < cb; i += 2)
+	{
+		ULONG ulChar = ReadWord(lpb + i);
+		if (ulChar >= 0xD800 && ulChar < 0xDC00 && i + 3 < cb)
+		{
+			ULONG ulLow = ReadWord(lpb + i + 2);
+			if (ulLow >= 0xDC00 && ulLow < 0xE000)
+			{
+				ulChar = 0x10000 + ((ulChar - 0xD800) << 10) + (ulLow - 0xDC00);
+				i += 2;
+			}
+		}
+
+		AppendUtf8(name, ulChar);
+	}
+
+	return name;
+}
+
+// Registry names compare case insensitively. We only fold ASCII, which covers profile data.
+bool RegfHive::IsSameName(const std::string& name1, const std::string& name2)
+{
+	if (name1.size() != name2.size()) return false;
+	for (size_t i = 0; i < name1.size(); i++)
+	{
+		auto ch1 = name1[i];
+		auto ch2 = name2[i];
+		if (ch1 >= 'a' && ch1 <= 'z') ch1 -= 'a' - 'A';
+		if (ch2 >= 'a' && ch2 <= 'z') ch2 -= 'a' - 'A';
+		if (ch1 != ch2) return false;
+	}
+
+	return true;
+}
+
+RegfHive::RegfHive() : m_hFile(nullptr), m_hMapping(nullptr), m_lpbView(nullptr), m_cbView(0), m_cbBins(0), m_fWritable(false)
+{
+}
+
+RegfHive::~RegfHive()
+{
+	Close();
+}
+
+HRESULT RegfHive::Open(_In_z_ LPCWSTR szPath, bool fWritable)
+{
+	Close();
+	m_fWritable = fWritable;
+
+	// A hive loaded by the system is held open exclusively, so this also keeps us off live hives
+	auto hFile = CreateFileW(
+		szPath,
+		GENERIC_READ | (fWritable ? GENERIC_WRITE : 0),
+		fWritable ? 0 : FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) return HRESULT_FROM_WIN32(GetLastError());
+	m_hFile = hFile;
+
+	LARGE_INTEGER size = {};
+	if (!GetFileSizeEx(m_hFile, &size))
+	{
+		auto hRes = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		return hRes;
+	}
+
+	if (size.QuadPart < cbBaseBlock)
+	{
+		Close();
+		return HRESULT_FROM_WIN32(ERROR_BADDB);
+	}
+
+	m_hMapping = CreateFileMappingW(m_hFile, nullptr, fWritable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+	if (m_hMapping)
+	{
+		m_lpbView = static_cast<BYTE*>(MapViewOfFile(m_hMapping, fWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+	}
+
+	if (!m_lpbView)
+	{
+		auto hRes = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		return hRes;
+	}
+
+	m_cbView = size.QuadPart;
+	m_cbBins = ReadDword(m_lpbView + ibBinsSize);
+
+	// Primary file, direct memory load format, version 1.x, with an intact base block
+	if (memcmp(m_lpbView, "regf", 4) != 0 ||
+		ReadDword(m_lpbView + ibMajorVersion) != 1 ||
+		ReadDword(m_lpbView + ibFileType) != 0 ||
+		ReadDword(m_lpbView + ibFileFormat) != 1 ||
+		ReadDword(m_lpbView + ibChecksum) != BaseBlockChecksum(m_lpbView) ||
+		cbBaseBlock + static_cast<ULONGLONG>(m_cbBins) > m_cbView ||
+		!GetKeyNode(GetRootKey()))
+	{
+		Close();
+		return HRESULT_FROM_WIN32(ERROR_BADDB);
+	}
+
+	return S_OK;
+}
+
+void RegfHive::Close()
+{
+	if (m_lpbView)
+	{
+		if (m_fWritable) (void) Flush();
+		UnmapViewOfFile(m_lpbView);
+	}
+
+	if (m_hMapping) CloseHandle(m_hMapping);
+	if (m_hFile) CloseHandle(m_hFile);
+
+	m_hFile = nullptr;
+	m_hMapping = nullptr;
+	m_lpbView = nullptr;
+	m_cbView = 0;
+	m_cbBins = 0;
+}
+
+bool RegfHive::IsDirty() const
+{
+	if (!m_lpbView) return false;
+	return ReadDword(m_lpbView + ibPrimarySequence) != ReadDword(m_lpbView + ibSecondarySequence);
+}
+
+HiveCell RegfHive::GetRootKey() const
+{
+	if (!m_lpbView) return hiveCellNone;
+	return ReadDword(m_lpbView + ibRootCell);
+}
+
+// Returns the contents of an allocated cell at least cbMin bytes long, or nullptr if
+// the cell is free or runs outside the hive bins
+const BYTE* RegfHive::GetCell(HiveCell cell, ULONG cbMin, _Out_opt_ ULONG* lpcbCell) const
+{
+	if (lpcbCell) *lpcbCell = 0;
+	if (!m_lpbView || cell == hiveCellNone) return nullptr;
+	if (static_cast<ULONGLONG>(cell) + sizeof(LONG) > m_cbBins) return nullptr;
+
+	auto lpbCell = m_lpbView + cbBaseBlock + cell;
+
+	// Allocated cells have a negative size, which includes the size field
+	auto lSize = static_cast<LONG>(ReadDword(lpbCell));
+	if (lSize >= 0) return nullptr;
+
+	auto cbCell = static_cast<ULONGLONG>(-static_cast<LONGLONG>(lSize));
+	if (cbCell < sizeof(LONG) + static_cast<ULONGLONG>(cbMin) || cell + cbCell > m_cbBins) return nullptr;
+
+	if (lpcbCell) *lpcbCell = static_cast<ULONG>(cbCell - sizeof(LONG));
+	return lpbCell + sizeof(LONG);
+}
+
+const BYTE* RegfHive::GetKeyNode(HiveCell key) const
+{
+	ULONG cbCell = 0;
+	auto lpbKey = GetCell(key, ibKeyName, &cbCell);
+	if (!lpbKey || lpbKey[0] != 'n' || lpbKey[1] != 'k') return nullptr;
+	if (ibKeyName + static_cast<ULONG>(ReadWord(lpbKey + ibKeyNameLength)) > cbCell) return nullptr;
+	return lpbKey;
+}
+
+std::string RegfHive::GetKeyName(HiveCell key) const
+{
+	auto lpbKey = GetKeyNode(key);
+	if (!lpbKey) return std::string();
+
+	return DecodeName(
+		lpbKey + ibKeyName,
+		ReadWord(lpbKey + ibKeyNameLength),
+		(ReadWord(lpbKey + ibKeyFlags) & KEY_COMP_NAME) != 0);
+}
+
+// Subkey lists are lf/lh (offset and hash pairs), li (offsets), or an ri index of those
+void RegfHive::AddSubkeys(HiveCell list, std::vector<HiveCell>& subkeys, int depth) const
+{
+	ULONG cbList = 0;
+	auto lpbList = GetCell(list, 4, &cbList);
+	if (!lpbList) return;
+
+	ULONG cEntries = ReadWord(lpbList + 2);
+	auto fIndex = lpbList[0] == 'r' && lpbList[1] == 'i';
+	ULONG cbEntry = 0;
+	if (lpbList[0] == 'l' && (lpbList[1] == 'f' || lpbList[1] == 'h')) cbEntry = 8;
+	else if ((lpbList[0] == 'l' && lpbList[1] == 'i') || fIndex) cbEntry = 4;
+	if (!cbEntry || 4 + static_cast<ULONGLONG>(cEntries) * cbEntry > cbList) return;
+
+	for (ULONG i = 0; i < cEntries; i++)
+	{
+		auto cell = ReadDword(lpbList + 4 + i * cbEntry);
+		if (!fIndex)
+		{
+			subkeys.push_back(cell);
+		}
+		else if (depth == 0)
+		{
+			// An index only ever points at leaves
+			AddSubkeys(cell, subkeys, depth + 1);
+		}
+	}
+}
+
+std::vector<HiveCell> RegfHive::GetSubkeys(HiveCell key) const
+{
+	std::vector<HiveCell> subkeys;
+	auto lpbKey = GetKeyNode(key);
+	if (lpbKey && ReadDword(lpbKey + ibSubkeyCount))
+	{
+		AddSubkeys(ReadDword(lpbKey + ibSubkeyList), subkeys, 0);
+	}
+
+	return subkeys;
+}
+
+HiveCell RegfHive::FindSubkey(HiveCell key, const std::string& name) const
+{
+	for (const auto subkey : GetSubkeys(key))
+	{
+		if (IsSameName(GetKeyName(subkey), name)) return subkey;
+	}
+
+	return hiveCellNone;
+}
+
+HiveCell RegfHive::OpenKey(HiveCell key, const std::string& path) const
+{
+	size_t ichStart = 0;
+	while (key != hiveCellNone && ichStart < path.size())
+	{
+		auto ichEnd = path.find('\\', ichStart);
+		if (ichEnd == std::string::npos) ichEnd = path.size();
+		if (ichEnd > ichStart) key = FindSubkey(key, path.substr(ichStart, ichEnd - ichStart));
+		ichStart = ichEnd + 1;
+	}
+
+	return key;
+}
+
+HiveCell RegfHive::FindValue(HiveCell key, const std::string& name) const
+{
+	auto lpbKey = GetKeyNode(key);
+	if (!lpbKey) return hiveCellNone;
+
+	auto cValues = ReadDword(lpbKey + ibValueCount);
+	if (!cValues || cValues > m_cbBins / sizeof(ULONG)) return hiveCellNone;
+
+	auto lpbList = GetCell(ReadDword(lpbKey + ibValueList), cValues * sizeof(ULONG));
+	if (!lpbList) return hiveCellNone;
+
+	for (ULONG i = 0; i < cValues; i++)
+	{
+		auto value = ReadDword(lpbList + i * sizeof(ULONG));
+		ULONG cbValue = 0;
+		auto lpbValue = GetCell(value, ibValueName, &cbValue);
+		if (!lpbValue || lpbValue[0] != 'v' || lpbValue[1] != 'k') continue;
+
+		ULONG cbName = ReadWord(lpbValue + ibValueNameLength);
+		if (ibValueName + cbName > cbValue) continue;
+
+		auto valueName = DecodeName(lpbValue + ibValueName, cbName, (ReadWord(lpbValue + ibValueFlags) & VALUE_COMP_NAME) != 0);
+		if (IsSameName(valueName, name)) return value;
+	}
+
+	return hiveCellNone;
+}
+
+bool RegfHive::GetValueData(HiveCell value, _Out_ const BYTE** lppb, _Out_ ULONG* lpcb, _Out_opt_ ULONG* lpulType) const
+{
+	*lppb = nullptr;
+	*lpcb = 0;
+	if (lpulType) *lpulType = 0;
+
+	auto lpbValue = GetCell(value, ibValueName);
+	if (!lpbValue || lpbValue[0] != 'v' || lpbValue[1] != 'k') return false;
+
+	auto cbData = ReadDword(lpbValue + ibDataSize);
+	if (lpulType) *lpulType = ReadDword(lpbValue + ibDataType);
+
+	if (cbData & DATA_IN_OFFSET)
+	{
+		cbData &= ~DATA_IN_OFFSET;
+		if (cbData > sizeof(ULONG)) return false;
+		*lppb = lpbValue + ibDataOffset;
+		*lpcb = cbData;
+		return true;
+	}
+
+	if (!cbData) return true;
+
+	// Large data in newer hives sits behind a db record, which is far too small to pass this
+	auto lpbData = GetCell(ReadDword(lpbValue + ibDataOffset), cbData);
+	if (!lpbData) return false;
+
+	*lppb = lpbData;
+	*lpcb = cbData;
+	return true;
+}
+
+HRESULT RegfHive::Flush() const
+{
+	if (!FlushViewOfFile(m_lpbView, 0) || !FlushFileBuffers(m_hFile)) return HRESULT_FROM_WIN32(GetLastError());
+	return S_OK;
+}
+
+// Writes to a hive are bracketed by its sequence numbers. Bumping the primary number marks
+// the hive dirty, and bringing the secondary number level afterwards marks it clean again.
+void RegfHive::UpdateBaseBlock(bool fComplete)
+{
+	auto ulSequence = ReadDword(m_lpbView + ibPrimarySequence);
+	if (!fComplete)
+	{
+		FILETIME ftNow = {};
+		GetSystemTimeAsFileTime(&ftNow);
+		WriteDword(m_lpbView + ibPrimarySequence, ulSequence + 1);
+		memcpy(m_lpbView + ibTimestamp, &ftNow, sizeof(ftNow));
+	}
+	else
+	{
+		WriteDword(m_lpbView + ibSecondarySequence, ulSequence);
+	}
+
+	WriteDword(m_lpbView + ibChecksum, BaseBlockChecksum(m_lpbView));
+}
+
+HRESULT RegfHive::SetValueData(HiveCell key, HiveCell value, _In_reads_bytes_(cb) const BYTE* lpb, ULONG cb)
+{
+	if (!m_lpbView || !m_fWritable) return E_ACCESSDENIED;
+	if (IsDirty()) return HRESULT_FROM_WIN32(ERROR_INVALID_STATE);
+
+	const BYTE* lpbData = nullptr;
+	ULONG cbData = 0;
+	auto lpbKey = GetKeyNode(key);
+	if (!lpbKey || !GetValueData(value, &lpbData, &cbData, nullptr)) return HRESULT_FROM_WIN32(ERROR_BADDB);
+	if (cbData != cb) return E_INVALIDARG;
+
+	// The view is writable, the const only comes from the lookup helpers
+	auto lpbTarget = m_lpbView + (lpbData - m_lpbView);
+	auto lpbKeyTarget = m_lpbView + (lpbKey - m_lpbView);
+
+	UpdateBaseBlock(false);
+	auto hRes = Flush();
+	if (SUCCEEDED(hRes))
+	{
+		FILETIME ftNow = {};
+		GetSystemTimeAsFileTime(&ftNow);
+		memcpy(lpbTarget, lpb, cb);
+		memcpy(lpbKeyTarget + ibKeyTimestamp, &ftNow, sizeof(ftNow));
+		hRes = Flush();
+	}
+
+	if (SUCCEEDED(hRes))
+	{
+		UpdateBaseBlock(true);
+		hRes = Flush();
+	}
+
+	return hRes;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <windows.h>
+#include <string>
+#include <vector>
+
+// Direct access to a registry hive file (REGF), such as an unloaded NTUSER.DAT,
+// through a memory mapped view. Only what profile repair needs is supported:
+// walking keys, reading values, and overwriting a value's data in place with data
+// of the same size. Nothing is ever allocated or freed in the hive.
+
+// Offset of a cell from the start of the hive bins
+typedef ULONG HiveCell;
+const HiveCell hiveCellNone = 0xFFFFFFFF;
+
+class RegfHive
+{
+public:
+	RegfHive();
+	~RegfHive();
+
+	// Maps the hive. Fails with ERROR_BADDB if the file isn't a hive we understand.
+	HRESULT Open(_In_z_ LPCWSTR szPath, bool fWritable);
+	void Close();
+
+	// A hive whose sequence numbers differ was not cleanly unloaded and has changes
+	// sitting in its .LOG files. Writing to it would be lost or corrupt it on replay.
+	bool IsDirty() const;
+
+	HiveCell GetRootKey() const;
+
+	// Name lookups are case insensitive. path is backslash separated.
+	HiveCell FindSubkey(HiveCell key, const std::string& name) const;
+	HiveCell OpenKey(HiveCell key, const std::string& path) const;
+	std::vector<HiveCell> GetSubkeys(HiveCell key) const;
+	std::string GetKeyName(HiveCell key) const;
+
+	HiveCell FindValue(HiveCell key, const std::string& name) const;
+
+	// Compares key or value names the way the registry does
+	static bool IsSameName(const std::string& name1, const std::string& name2);
+
+	// Points lppb at the value's data inside the mapped view. Returns false for values
+	// whose data is split over several cells, which profile values never are.
+	bool GetValueData(HiveCell value, _Out_ const BYTE** lppb, _Out_ ULONG* lpcb, _Out_opt_ ULONG* lpulType) const;
+
+	// Overwrites the value's data, which must stay the same size, and marks key as written.
+	// The base block is updated the way Windows does it, so the hive stays consistent if
+	// we are interrupted part way.
+	HRESULT SetValueData(HiveCell key, HiveCell value, _In_reads_bytes_(cb) const BYTE* lpb, ULONG cb);
+
+private:
+	const BYTE* GetCell(HiveCell cell, ULONG cbMin, _Out_opt_ ULONG* lpcbCell = nullptr) const;
+	const BYTE* GetKeyNode(HiveCell key) const;
+	void AddSubkeys(HiveCell list, std::vector<HiveCell>& subkeys, int depth) const;
+	HRESULT Flush() const;
+	void UpdateBaseBlock(bool fComplete);
+
+	HANDLE m_hFile;
+	HANDLE m_hMapping;
+	BYTE* m_lpbView;
+	ULONGLONG m_cbView;
+	ULONG m_cbBins;
+	bool m_fWritable;
+};
@@ -0,0 +1,147 @@
+#include "stdafx.h"
+#include "RegistryPrecheck.h"
+#include <MAPITags.h>
+#include "OfflineProfiles.h"
+#include "ProviderOrder.h"
+
+// Registry key names are at most 255 characters
+const DWORD cchMaxKeyName = 256;
+
+static std::vector<std::string> GetSubkeyNames(HKEY hKey)
+{
+	std::vector<std::string> names;
+	char szName[cchMaxKeyName];
+	for (DWORD i = 0;; i++)
+	{
+		DWORD cchName = _countof(szName);
+		auto ret = RegEnumKeyExA(hKey, i, szName, &cchName, nullptr, nullptr, nullptr, nullptr);
+		if (ret == ERROR_MORE_DATA) continue;
+		if (ret != ERROR_SUCCESS) break;
+
+		names.push_back(std::string(szName, cchName));
+	}
+
+	return names;
+}
+
+// Reads a REG_BINARY value. Returns false if it's missing or some other type.
+static bool GetBinaryValue(HKEY hKey, ULONG ulPropTag, std::vector<BYTE>& data)
+{
+	auto name = PropTagValueName(ulPropTag);
+	DWORD dwType = 0;
+	DWORD cb = 0;
+	if (RegQueryValueExA(hKey, name.c_str(), nullptr, &dwType, nullptr, &cb) != ERROR_SUCCESS || dwType != REG_BINARY)
+	{
+		return false;
+	}
+
+	data.resize(cb);
+	if (!cb) return true;
+
+	return RegQueryValueExA(hKey, name.c_str(), nullptr, &dwType, data.data(), &cb) == ERROR_SUCCESS && cb == data.size();
+}
+
+// Matches FindOfflineServiceSection: the section has the service name and is named for its PR_SERVICE_UID
+static bool IsServiceSection(HKEY hSection, const std::string& sectionName, const std::string& serviceName)
+{
+	std::vector<BYTE> data;
+	auto fUnicode = false;
+	if (!GetBinaryValue(hSection, PR_SERVICE_NAME_A, data))
+	{
+		if (!GetBinaryValue(hSection, PR_SERVICE_NAME_W, data)) return false;
+		fUnicode = true;
+	}
+
+	SBinary name = { static_cast<ULONG>(data.size()), data.data() };
+	if (!IsServiceName(name, fUnicode, serviceName)) return false;
+
+	if (!GetBinaryValue(hSection, PR_SERVICE_UID, data)) return true;
+
+	return data.size() == sizeof(MAPIUID) &&
+		RegfHive::IsSameName(SectionKeyName(*reinterpret_cast<LPMAPIUID>(data.data())), sectionName);
+}
+
+static PrecheckResult PrecheckProfileKey(HKEY hProfile)
+{
+	std::vector<BYTE> contabProviders;
+	auto fContabFound = false;
+	for (const auto& sectionName : GetSubkeyNames(hProfile))
+	{
+		HKEY hSection = nullptr;
+		if (RegOpenKeyExA(hProfile, sectionName.c_str(), 0, KEY_READ, &hSection) != ERROR_SUCCESS) continue;
+
+		if (IsServiceSection(hSection, sectionName, "CONTAB"))
+		{
+			fContabFound = true;
+			if (!GetBinaryValue(hSection, PR_AB_PROVIDERS, contabProviders)) contabProviders.clear();
+		}
+
+		RegCloseKey(hSection);
+		if (fContabFound) break;
+	}
+
+	// FixProfile has nothing to do in a profile without contab
+	if (!fContabFound) return PrecheckResult::Healthy;
+	if (contabProviders.size() != sizeof(MAPIUID)) return PrecheckResult::Unknown;
+
+	HKEY hProviders = nullptr;
+	if (RegOpenKeyExA(hProfile, SectionKeyName(muidProviderSection).c_str(), 0, KEY_READ, &hProviders) != ERROR_SUCCESS)
+	{
+		return PrecheckResult::Unknown;
+	}
+
+	std::vector<BYTE> providers;
+	auto fRead = GetBinaryValue(hProviders, PR_AB_PROVIDERS, providers);
+	RegCloseKey(hProviders);
+
+	SBinary bin = { static_cast<ULONG>(providers.size()), providers.data() };
+	if (!fRead || !IsValidProviderList(&bin)) return PrecheckResult::Unknown;
+
+	auto iContab = FindProviderUID(bin, *reinterpret_cast<LPMAPIUID>(contabProviders.data()));
+	return iContab == 0 || iContab == ulProviderNotFound ? PrecheckResult::Healthy : PrecheckResult::NeedsRepair;
+}
+
+std::vector<std::string> GetRegistryProfileNames()
+{
+	std::vector<std::string> profileNames;
+	for (const auto szRoot : rgszProfileRoots)
+	{
+		HKEY hRoot = nullptr;
+		if (RegOpenKeyExA(HKEY_CURRENT_USER, szRoot, 0, KEY_READ, &hRoot) != ERROR_SUCCESS) continue;
+
+		for (const auto& profileName : GetSubkeyNames(hRoot))
+		{
+			auto fListed = false;
+			for (const auto& listed : profileNames)
+			{
+				if (RegfHive::IsSameName(listed, profileName)) fListed = true;
+			}
+
+			if (!fListed) profileNames.push_back(profileName);
+		}
+
+		RegCloseKey(hRoot);
+	}
+
+	return profileNames;
+}
+
+PrecheckResult PrecheckProfile(const std::string& profileName)
+{
+	auto result = PrecheckResult::Unknown;
+	for (const auto szRoot : rgszProfileRoots)
+	{
+		HKEY hProfile = nullptr;
+		auto path = std::string(szRoot) + "\\" + profileName;
+		if (RegOpenKeyExA(HKEY_CURRENT_USER, path.c_str(), 0, KEY_READ, &hProfile) != ERROR_SUCCESS) continue;
+
+		auto profileResult = PrecheckProfileKey(hProfile);
+		RegCloseKey(hProfile);
+
+		// We don't know which root the MAPI in use reads, so any copy that isn't healthy sends the profile to MAPI
+		if (profileResult != PrecheckResult::Healthy) return profileResult;
+		result = PrecheckResult::Healthy;
+	}
+
+	return result;
+}
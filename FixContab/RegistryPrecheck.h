@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Reads profiles straight from the registry under HKEY_CURRENT_USER, so the profiles that are
+// already right can be skipped without loading MAPI. MAPI keeps each profile in the same keys
+// and values OfflineProfiles reads from hive files. Anything unexpected is left to MAPI.
+
+enum class PrecheckResult
+{
+	Healthy,     // Nothing to write: contab is first, or isn't in the profile or its providers list
+	NeedsRepair, // Contab is in the providers list, but not first
+	Unknown,     // The profile couldn't be found or read
+};
+
+// Name of every profile under each of the profile roots
+std::vector<std::string> GetRegistryProfileNames();
+
+// Checks every copy of the profile under the profile roots. Only Healthy if they all are.
+PrecheckResult PrecheckProfile(const std::string& profileName);
@@ -0,0 +1,70 @@
+#include "stdafx.h"
+#include "RowCursor.h"
+#include <MAPIUtil.h>
+
+RowCursor::~RowCursor()
+{
+	Close();
+}
+
+void RowCursor::Close()
+{
+	FreeProws(m_lpRows);
+	m_lpRows = nullptr;
+	if (m_lpTable) m_lpTable->Release();
+	m_lpTable = nullptr;
+	m_iRow = 0;
+	m_fEnd = false;
+	m_hRes = S_OK;
+}
+
+HRESULT RowCursor::Open(_In_ LPMAPITABLE lpTable, _In_opt_ LPSPropTagArray lpColumns, LONG cRowsPerBatch)
+{
+	Close();
+	if (!lpTable || cRowsPerBatch <= 0)
+	{
+		m_fEnd = true;
+		m_hRes = MAPI_E_INVALID_PARAMETER;
+		return m_hRes;
+	}
+
+	if (lpColumns)
+	{
+		m_hRes = lpTable->SetColumns(lpColumns, TBL_BATCH);
+		if (FAILED(m_hRes))
+		{
+			m_fEnd = true;
+			return m_hRes;
+		}
+	}
+
+	lpTable->AddRef();
+	m_lpTable = lpTable;
+	m_cRowsPerBatch = cRowsPerBatch;
+	return S_OK;
+}
+
+const SRow* RowCursor::Next()
+{
+	while (!m_lpRows || m_iRow >= m_lpRows->cRows)
+	{
+		if (m_fEnd || !m_lpTable) return nullptr;
+
+		// Freed before the next batch is read, so the two are never held together
+		FreeProws(m_lpRows);
+		m_lpRows = nullptr;
+		m_iRow = 0;
+
+		auto hRes = m_lpTable->QueryRows(m_cRowsPerBatch, 0, &m_lpRows);
+		if (FAILED(hRes))
+		{
+			m_hRes = hRes;
+			m_lpRows = nullptr;
+		}
+
+		// A short batch may not be the last, but an empty one is
+		if (!m_lpRows || !m_lpRows->cRows) m_fEnd = true;
+	}
+
+	return &m_lpRows->aRow[m_iRow++];
+}
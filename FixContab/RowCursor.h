@@ -0,0 +1,128 @@
+#pragma once
+#include <MAPIX.h>
+
+// Reads a table a batch of rows at a time with QueryRows, in place of HrQueryAllRows. Only one
+// batch is held at once, each freed as the next is read, so memory stays bounded by the batch
+// size however long the table is, and the first rows can be used as soon as their batch is in.
+//
+//	RowCursor cursor;
+//	hRes = cursor.Open(lpTable, columns, 16);
+//	for (const auto& row : cursor) { ... break whenever ... }
+//	hRes = cursor.GetResult();
+//
+// Stopping early just leaves the rest of the table unread.
+class RowCursor
+{
+public:
+	RowCursor() = default;
+	~RowCursor();
+
+	RowCursor(const RowCursor&) = delete;
+	RowCursor& operator=(const RowCursor&) = delete;
+
+	// Sets the columns, if lpColumns isn't nullptr, and starts reading from wherever the table is,
+	// the first row of a table that's just been opened or restricted. Holds a reference to
+	// lpTable until the cursor is destroyed or opened again.
+	HRESULT Open(_In_ LPMAPITABLE lpTable, _In_opt_ LPSPropTagArray lpColumns, LONG cRowsPerBatch);
+
+	// The next row, reading the next batch if this one is done. nullptr at the end of the table,
+	// or if a QueryRows failed. The row is valid until the next call.
+	const SRow* Next();
+
+	// The first failure, or S_OK. Reaching the end of the table isn't one.
+	HRESULT GetResult() const { return m_hRes; }
+
+	class iterator
+	{
+	public:
+		explicit iterator(_In_opt_ RowCursor* lpCursor) : m_lpCursor(lpCursor), m_lpRow(lpCursor ? lpCursor->Next() : nullptr) {}
+
+		const SRow& operator*() const { return *m_lpRow; }
+		const SRow* operator->() const { return m_lpRow; }
+		iterator& operator++() { m_lpRow = m_lpCursor->Next(); return *this; }
+
+		// Only the end of the table is ever compared against
+		bool operator!=(const iterator& other) const { return m_lpRow != other.m_lpRow; }
+
+	private:
+		RowCursor* m_lpCursor;
+		const SRow* m_lpRow;
+	};
+
+	// Reads from wherever the cursor is. A cursor is only meant to be iterated once.
+	iterator begin() { return iterator(this); }
+	iterator end() { return iterator(nullptr); }
+
+private:
+	void Close();
+
+	LPMAPITABLE m_lpTable = nullptr;
+	LPSRowSet m_lpRows = nullptr;
+	LONG m_cRowsPerBatch = 0;
+	ULONG m_iRow = 0; // Next row of m_lpRows to hand out
+	bool m_fEnd = false;
+	HRESULT m_hRes = S_OK;
+};
+
+// Finds a row's columns by tag in one pass over its values, rather than trusting each to be where
+// SetColumns asked for it or scanning the row once per tag. Providers that add columns, move
+// them, or return PT_ERROR for a column it doesn't have are all handled the same way: a column
+// only counts if its value has exactly the tag asked for. Indexes are into lpColumns, so they can
+// be the same enum used to build the SizedSPropTagArray.
+template <ULONG cColumns> class RowView
+{
+public:
+	RowView(const SRow& row, const SPropTagArray& columns)
+	{
+		for (ULONG iColumn = 0; iColumn < cColumns; iColumn++) m_rgpProps[iColumn] = nullptr;
+
+		const auto cRequested = columns.cValues < cColumns ? columns.cValues : cColumns;
+		for (ULONG iProp = 0; iProp < row.cValues; iProp++)
+		{
+			const auto ulPropTag = row.lpProps[iProp].ulPropTag;
+
+			// Nearly always the column is where it was asked for
+			if (iProp < cRequested && columns.aulPropTag[iProp] == ulPropTag)
+			{
+				if (!m_rgpProps[iProp]) m_rgpProps[iProp] = &row.lpProps[iProp];
+				continue;
+			}
+
+			for (ULONG iColumn = 0; iColumn < cRequested; iColumn++)
+			{
+				if (columns.aulPropTag[iColumn] == ulPropTag && !m_rgpProps[iColumn])
+				{
+					m_rgpProps[iColumn] = &row.lpProps[iProp];
+					break;
+				}
+			}
+		}
+	}
+
+	// The column's value, or nullptr if the row doesn't have it
+	const SPropValue* Get(ULONG iColumn) const { return iColumn < cColumns ? m_rgpProps[iColumn] : nullptr; }
+
+	// The value of a PT_STRING8 column, or nullptr
+	LPCSTR String8(ULONG iColumn) const
+	{
+		auto lpProp = Get(iColumn);
+		return lpProp && PROP_TYPE(lpProp->ulPropTag) == PT_STRING8 ? lpProp->Value.lpszA : nullptr;
+	}
+
+	// The value of a PT_BINARY column, or nullptr
+	const SBinary* Binary(ULONG iColumn) const
+	{
+		auto lpProp = Get(iColumn);
+		return lpProp && PROP_TYPE(lpProp->ulPropTag) == PT_BINARY ? &lpProp->Value.bin : nullptr;
+	}
+
+	// The value of a PT_LONG column, or lDefault
+	LONG Long(ULONG iColumn, LONG lDefault) const
+	{
+		auto lpProp = Get(iColumn);
+		return lpProp && PROP_TYPE(lpProp->ulPropTag) == PT_LONG ? lpProp->Value.l : lDefault;
+	}
+
+private:
+	const SPropValue* m_rgpProps[cColumns];
+};
@@ -0,0 +1,66 @@
+#include "stdafx.h"
+#include "SectionProps.h"
+#include <MAPITags.h>
+
+// In SectionProp order
+SizedSPropTagArray(cSectionProps, sectionPropTags) = { cSectionProps,
+	{
+		PR_AB_PROVIDERS,
+		PR_STORE_PROVIDERS,
+		PR_TRANSPORT_PROVIDERS,
+		PR_SERVICE_UID,
+		PR_PROVIDER_UID,
+		PR_AB_SEARCH_PATH,
+	}
+};
+
+ULONG SectionPropTag(SectionProp prop)
+{
+	return prop < cSectionProps ? sectionPropTags.aulPropTag[prop] : PR_NULL;
+}
+
+const SBinary* SectionPropsView::Get(SectionProp prop) const
+{
+	if (!m_lpProps || PROP_TYPE(SectionPropTag(prop)) != PT_BINARY) return nullptr;
+
+	// Missing properties come back as PT_ERROR
+	const auto& value = m_lpProps[prop];
+	if (value.ulPropTag != sectionPropTags.aulPropTag[prop]) return nullptr;
+
+	return &value.Value.bin;
+}
+
+const SBinaryArray* SectionPropsView::GetArray(SectionProp prop) const
+{
+	if (!m_lpProps || PROP_TYPE(SectionPropTag(prop)) != PT_MV_BINARY) return nullptr;
+
+	const auto& value = m_lpProps[prop];
+	if (value.ulPropTag != sectionPropTags.aulPropTag[prop]) return nullptr;
+
+	return &value.Value.MVbin;
+}
+
+SectionProps::~SectionProps()
+{
+	MAPIFreeBuffer(m_lpProps);
+}
+
+HRESULT SectionProps::Read(_In_ LPPROFSECT section)
+{
+	MAPIFreeBuffer(m_lpProps);
+	m_lpProps = nullptr;
+
+	ULONG cValues = 0;
+	LPSPropValue lpProps = nullptr;
+	auto hRes = section->GetProps(reinterpret_cast<LPSPropTagArray>(&sectionPropTags), 0, &cValues, &lpProps);
+	if (FAILED(hRes)) return hRes;
+
+	if (!lpProps || cValues != cSectionProps)
+	{
+		MAPIFreeBuffer(lpProps);
+		return MAPI_E_CALL_FAILED;
+	}
+
+	m_lpProps = lpProps;
+	return S_OK;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <MAPIX.h>
+
+// The provider lists and UIDs we read from a profile section. Every GetProps on a profile
+// section is a round trip to the registry inside MAPI, so they're all fetched in one call.
+
+enum SectionProp
+{
+	spABProviders,
+	spStoreProviders,
+	spTransportProviders,
+	spServiceUID,
+	spProviderUID,
+	spABSearchPath,
+	cSectionProps,
+};
+
+// Points into the block GetProps returned, without copying anything out of it.
+// Only valid while the SectionProps it came from is.
+class SectionPropsView
+{
+public:
+	SectionPropsView() : m_lpProps(nullptr) {}
+	explicit SectionPropsView(_In_opt_ const SPropValue* lpProps) : m_lpProps(lpProps) {}
+
+	// The property's value, or nullptr if the section doesn't have it
+	const SBinary* Get(SectionProp prop) const;
+
+	// The same for multi-valued properties, which is only spABSearchPath
+	const SBinaryArray* GetArray(SectionProp prop) const;
+
+private:
+	const SPropValue* m_lpProps;
+};
+
+// Property tag of a SectionProp
+ULONG SectionPropTag(SectionProp prop);
+
+// Owns the block GetProps returned and frees it with MAPIFreeBuffer
+class SectionProps
+{
+public:
+	SectionProps() : m_lpProps(nullptr) {}
+	~SectionProps();
+
+	SectionProps(const SectionProps&) = delete;
+	SectionProps& operator=(const SectionProps&) = delete;
+
+	// Reads every SectionProp from section. Properties the section doesn't have are not an error.
+	HRESULT Read(_In_ LPPROFSECT section);
+
+	SectionPropsView View() const { return SectionPropsView(m_lpProps); }
+
+private:
+	LPSPropValue m_lpProps;
+};
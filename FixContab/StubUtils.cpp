@@ -4,6 +4,14 @@
 #include <msi.h>
 #include <winreg.h>
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "StubUtils.h"
 
 /*
  *  MAPI Stub Utilities
@@ -24,10 +32,34 @@
  *			on the system, instead of respecting the system MAPI registration
  *			(HKLM\Software\Clients\Mail). This call must be made prior to any MAPI
  *			function calls.
+ *
+ *		SetMAPIDiscoveryBackoff()
+ *		InvalidateMAPIDiscovery()
+ *			When no MAPI DLL can be found, GetPrivateMAPI doesn't look again until a
+ *			backoff has passed, which doubles with each failure in a row. These set the
+ *			initial backoff, and forget the failures so the next call looks again.
+ *
+ *		SetMAPIExports()
+ *			Binds the stubs to a table of in-process MAPI functions. While a table is
+ *			bound, no MAPI DLL is loaded and every stub resolves against the table.
+ *
+ *		SetMAPIPathCache()
+ *			Names a file in which the path discovery settles on is kept, with the registry
+ *			values and file size and time it was found from. While they still match, the
+ *			next process loads that path without searching.
+ *
+ *		SetMAPIRegistry()
+ *			Chooses where discovery reads the mail client registration from: the registry
+ *			a value at a time (the default), or a snapshot of Software\Clients\Mail taken
+ *			in one pass as discovery starts.
+ *
+ *		SetMAPIBackend()
+ *			Chooses how MAPI is loaded when no table is bound: by searching for Outlook's
+ *			or the system's MAPI DLL (the default), or from a given DLL.
+ *
+ *	The binding may change on any thread. Each change publishes a new snapshot of the stubs'
+ *	function pointers (see BindMAPIStubs), which a stub reads with a single acquire load.
  */
-HMODULE GetPrivateMAPI();
-void UnLoadPrivateMAPI();
-void ForceOutlookMAPI();
 
 const WCHAR WszKeyNameMailClient[] = L"Software\\Clients\\Mail";
 const WCHAR WszValueNameDllPathEx[] = L"DllPathEx";
@@ -35,6 +67,8 @@ const WCHAR WszValueNameDllPath[] = L"DllPath";
 
 const CHAR SzValueNameMSI[] = "MSIComponentID";
 const CHAR SzValueNameLCID[] = "MSIApplicationLCID";
+const WCHAR WszValueNameMSI[] = L"MSIComponentID";
+const WCHAR WszValueNameLCID[] = L"MSIApplicationLCID";
 
 const WCHAR WszOutlookMapiClientName[] = L"Microsoft Outlook";
 
@@ -49,9 +83,11 @@ static const WCHAR WszMapiStub[] = L"mapistub.dll";
 
 static const CHAR SzFGetComponentPath[] = "FGetComponentPath";
 
+static const char rgchMAPIPathCacheSignature[4] = { 'F', 'C', 'M', '1' };
+
 // Sequence number which is incremented every time we set our MAPI handle which will
 //  cause a re-fetch of all stored function pointers
-volatile ULONG g_ulDllSequenceNum = 1;
+std::atomic<ULONG> g_ulDllSequenceNum(1);
 
 // Whether or not we should ignore the system MAPI registration and always try to find
 //  Outlook and its MAPI DLLs
@@ -60,14 +96,131 @@ static bool s_fForceOutlookMAPI = false;
 // Whether or not we should ignore the registry and load MAPI from the system directory
 static bool s_fForceSystemMAPI = false;
 
-static volatile HMODULE g_hinstMAPI = NULL;
+// Backoff after the first failed discovery. Each failure in a row doubles it, up to
+// 2^ulMaxMAPIDiscoveryBackoffShift times this.
+const ULONG ulDefaultMAPIDiscoveryBackoff = 5000;
+const ULONG ulMaxMAPIDiscoveryBackoffShift = 6;
+
+static std::atomic<ULONG> g_ulMAPIDiscoveryBackoff(ulDefaultMAPIDiscoveryBackoff);
+static std::atomic<ULONG> g_cMAPIDiscoveryFailures(0);
+
+typedef bool (STDAPICALLTYPE *FGetComponentPathType)(LPCSTR, LPSTR, LPSTR, DWORD, bool);
+
+// mapi32.dll, or mapistub.dll without it, loaded the first time discovery needs FGetComponentPath
+// and kept for the life of the process, so every later lookup is a plain call
+static std::atomic<HMODULE> g_hinstMAPIStubDll(NULL);
+static std::atomic<FGetComponentPathType> g_lpfnFGetComponentPath(NULL);
+
+// GetTickCount64 value before which discovery isn't retried, or 0 if it hasn't failed
+static std::atomic<ULONGLONG> g_ullMAPIDiscoveryRetry(0);
+
+// Where GetPrivateMAPI's discovery is. Guarded by g_srwMAPIDiscovery. Threads that find a
+// discovery in progress wait on g_cvMAPIDiscovery for its result.
+enum MAPIDiscoveryState
+{
+	mdsUnbound,
+	mdsBinding,
+	mdsBound,
+	mdsFailed,
+};
+
+static MAPIDiscoveryState g_mapiDiscoveryState = mdsUnbound;
+static SRWLOCK g_srwMAPIDiscovery = SRWLOCK_INIT;
+static CONDITION_VARIABLE g_cvMAPIDiscovery = CONDITION_VARIABLE_INIT;
+
+static std::atomic<HMODULE> g_hinstMAPI(NULL);
 HMODULE g_hModPstPrx32 = NULL;
 
+static std::atomic<const MAPIBackend*> g_lpMAPIBackend(&mapiDiscoveryBackend);
+
+static const MAPIBackend* GetMAPIBackend()
+{
+	return g_lpMAPIBackend.load(std::memory_order_acquire);
+} // GetMAPIBackend
+
 HMODULE GetMAPIHandle()
 {
-	return g_hinstMAPI;
+	return g_hinstMAPI.load(std::memory_order_acquire);
 } // GetMAPIHandle
 
+// In-process export table set by SetMAPIExports. The pointer and count are published together
+// so a reader on another thread never pairs one table with another's count.
+struct MAPIExportTable
+{
+	const MAPIExport* lpExports;
+	ULONG cExports;
+	MAPIExportTable* lpNextRetired;
+};
+
+static std::atomic<MAPIExportTable*> g_lpMAPIExports(NULL);
+
+// Replaced tables. Another thread may still be searching one, so they're kept rather than freed.
+// They're tiny and a process only binds a handful of times.
+static std::atomic<MAPIExportTable*> g_lpRetiredMAPIExports(NULL);
+
+void SetMAPIExports(_In_reads_opt_(cExports) const MAPIExport* lpExports, ULONG cExports)
+{
+	auto lpTable = lpExports ? new MAPIExportTable{ lpExports, cExports, NULL } : NULL;
+	auto lpPrev = g_lpMAPIExports.exchange(lpTable, std::memory_order_acq_rel);
+	if (lpPrev)
+	{
+		auto lpRetired = g_lpRetiredMAPIExports.load(std::memory_order_relaxed);
+		do
+		{
+			lpPrev->lpNextRetired = lpRetired;
+		} while (!g_lpRetiredMAPIExports.compare_exchange_weak(lpRetired, lpPrev, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	// Function pointers cached by the stubs point into whatever was bound before
+	g_ulDllSequenceNum.fetch_add(1, std::memory_order_acq_rel);
+	(void)BindMAPIStubs();
+} // SetMAPIExports
+
+/*
+ *  GetMAPIProcAddress
+ *		GetProcAddress against the bound export table if there is one, otherwise whatever the
+ *		backend loaded.
+ *		x86 lookups carry a stdcall decoration ("MAPIInitialize@4") which the table omits.
+ *		Ordinal lookups are only supported by a DLL.
+ */
+FARPROC GetMAPIProcAddress(_In_ LPCSTR lpszProcName)
+{
+	if (NULL == g_lpMAPIExports.load(std::memory_order_acquire))
+	{
+		return ResolveMAPIExport(GetPrivateMAPI(), lpszProcName);
+	}
+
+	return ResolveMAPIExport(NULL, lpszProcName);
+} // GetMAPIProcAddress
+
+FARPROC ResolveMAPIExport(HMODULE hinstMAPI, _In_ LPCSTR lpszProcName)
+{
+	auto lpTable = g_lpMAPIExports.load(std::memory_order_acquire);
+	if (NULL == lpTable)
+	{
+		return NULL != hinstMAPI ? GetMAPIBackend()->lpfnGetProcAddress(hinstMAPI, lpszProcName) : NULL;
+	}
+
+	if (IS_INTRESOURCE(lpszProcName)) return NULL;
+
+	auto cchName = strcspn(lpszProcName, "@");
+	for (ULONG i = 0; i < lpTable->cExports; i++)
+	{
+		const auto& mapiExport = lpTable->lpExports[i];
+		if (strlen(mapiExport.szName) == cchName && 0 == strncmp(mapiExport.szName, lpszProcName, cchName))
+		{
+			return mapiExport.lpfn;
+		}
+	}
+
+	return NULL;
+} // ResolveMAPIExport
+
+bool IsMAPIBound()
+{
+	return NULL != g_lpMAPIExports.load(std::memory_order_acquire) || NULL != GetMAPIHandle();
+} // IsMAPIBound
+
 enum mapiSource;
 class MAPIPathIterator
 {
@@ -77,15 +230,18 @@ public:
 	LPWSTR GetNextMAPIPath();
 	LPWSTR GetMAPISystemDir();
 
+	// The sources GetNextMAPIPath goes through, in order, for resolving each one separately
+	mapiSource GetCurrentSource() const;
+	mapiSource GetNextSource(mapiSource source) const;
+	LPWSTR GetMAPIPath(mapiSource source);
+
 private:
 	LPWSTR GetRegisteredMapiClient(LPCWSTR pwzProviderOverride, bool bDLL, bool bEx);
-	LPWSTR GetMailClientFromMSIData(HKEY hkeyMapiClient);
-	LPWSTR GetMailClientFromDllPath(HKEY hkeyMapiClient, bool bEx);
+	LPWSTR GetMailClientFromMSIData(LPCWSTR szMapiClientKey);
+	LPWSTR GetMailClientFromDllPath(LPCWSTR szMapiClientKey, bool bEx);
 
 	mapiSource CurrentSource;
-	HKEY m_hMailKey;
-	HKEY m_hkeyMapiClient;
-	LPWSTR m_rgchMailClient;
+	std::wstring m_szMailClient;
 	LPCWSTR m_szRegisteredClient;
 	bool m_bBypassRestrictions;
 
@@ -115,65 +271,240 @@ void SetMAPIHandle(HMODULE hinstMAPI)
 			g_hModPstPrx32 = NULL;
 		}
 
-		hinstToFree = (HMODULE)InterlockedExchangePointer((PVOID*)&g_hinstMAPI, (PVOID)hinstNULL);
+		hinstToFree = g_hinstMAPI.exchange(hinstNULL, std::memory_order_acq_rel);
+
+		// Clear the stubs before the DLL they point into goes away
+		if (NULL != hinstToFree)
+		{
+			g_ulDllSequenceNum.fetch_add(1, std::memory_order_acq_rel);
+			(void)BindMAPIStubs();
+		}
 	}
 	else
 	{
-		// Set the value only if the global is NULL
-		HMODULE	hinstPrev;
-		// Code Analysis gives us a C28112 error when we use InterlockedCompareExchangePointer, so we instead exchange, check and exchange back
-		//hinstPrev = (HMODULE)InterlockedCompareExchangePointer(reinterpret_cast<volatile PVOID*>(&g_hinstMAPI), hinstMAPI, hinstNULL);
-		hinstPrev = (HMODULE)InterlockedExchangePointer((PVOID*)&g_hinstMAPI, (PVOID)hinstMAPI);
-		if (NULL != hinstPrev)
+		// Set the value only if the global is NULL. Otherwise another thread got there first, so we
+		// free ours and keep theirs. Comparing and exchanging in one step means no other thread
+		// ever sees the handle we're about to free.
+		if (!g_hinstMAPI.compare_exchange_strong(hinstNULL, hinstMAPI, std::memory_order_acq_rel))
 		{
-			(void)InterlockedExchangePointer((PVOID*)&g_hinstMAPI, (PVOID)hinstPrev);
 			hinstToFree = hinstMAPI;
 		}
-
-		// If we've updated our MAPI handle, any previous addressed fetched via GetProcAddress are invalid, so we
-		// have to increment a sequence number to signal that they need to be re-fetched
-		InterlockedIncrement(reinterpret_cast<volatile LONG*>(&g_ulDllSequenceNum));
+		else
+		{
+			// If we've updated our MAPI handle, any previous addressed fetched via GetProcAddress are invalid, so we
+			// have to increment a sequence number to signal that they need to be re-fetched
+			g_ulDllSequenceNum.fetch_add(1, std::memory_order_acq_rel);
+			(void)BindMAPIStubs();
+		}
 	}
 	if (NULL != hinstToFree)
 	{
-		FreeLibrary(hinstToFree);
+		GetMAPIBackend()->lpfnFree(hinstToFree);
 	}
 } // SetMAPIHandle
 
+/*
+ *  ExpandRegString
+ *		Expands a REG_EXPAND_SZ value in place. REG_SZ values are left as they are.
+ */
+static DWORD ExpandRegString(DWORD dwType, std::wstring& value)
+{
+	if (REG_SZ == dwType) return ERROR_SUCCESS;
+	if (REG_EXPAND_SZ != dwType) return ERROR_INVALID_DATA;
+
+	auto cch = ExpandEnvironmentStringsW(value.c_str(), NULL, 0);
+	if (!cch) return GetLastError();
+
+	std::wstring expanded(cch, L'\0');
+	cch = ExpandEnvironmentStringsW(value.c_str(), &expanded[0], cch);
+	if (!cch || cch > expanded.size()) return ERROR_INSUFFICIENT_BUFFER;
+
+	expanded.resize(cch - 1);
+	value.swap(expanded);
+	return ERROR_SUCCESS;
+} // ExpandRegString
+
 /*
  *  RegQueryWszExpand
- *		Wrapper for RegQueryValueExW which automatically expands REG_EXPAND_SZ values
+ *		Wrapper for RegQueryValueExW which automatically expands REG_EXPAND_SZ values, at
+ *		whatever length they are
  */
-DWORD RegQueryWszExpand(HKEY hKey, LPCWSTR lpValueName, LPWSTR lpValue, DWORD cchValueLen)
+static DWORD RegQueryWszExpand(HKEY hKey, _In_opt_z_ LPCWSTR lpValueName, std::wstring& value)
 {
-	DWORD dwErr = ERROR_SUCCESS;
 	DWORD dwType = 0;
+	DWORD cbValue = 0;
+	auto dwErr = static_cast<DWORD>(RegQueryValueExW(hKey, lpValueName, 0, &dwType, NULL, &cbValue));
 
-	WCHAR rgchValue[MAX_PATH] = { 0 };
-	DWORD dwSize = sizeof(rgchValue);
+	// The value can grow between asking its size and reading it, so ask again if it has
+	std::vector<BYTE> buffer;
+	while (ERROR_SUCCESS == dwErr || ERROR_MORE_DATA == dwErr)
+	{
+		buffer.resize(cbValue + sizeof(WCHAR));
+		cbValue = static_cast<DWORD>(buffer.size());
+		dwErr = static_cast<DWORD>(RegQueryValueExW(hKey, lpValueName, 0, &dwType, buffer.data(), &cbValue));
+		if (ERROR_SUCCESS == dwErr) break;
+	}
 
-	dwErr = RegQueryValueExW(hKey, lpValueName, 0, &dwType, (LPBYTE)&rgchValue, &dwSize);
+	if (ERROR_SUCCESS != dwErr) return dwErr;
+
+	// Registry strings needn't be null terminated
+	value.assign(reinterpret_cast<LPCWSTR>(buffer.data()), cbValue / sizeof(WCHAR));
+	value.resize(wcsnlen(value.c_str(), value.size()));
+	return ExpandRegString(dwType, value);
+} // RegQueryWszExpand
+
+static DWORD QueryWin32Registry(_In_z_ LPCWSTR szKey, _In_opt_z_ LPCWSTR szValueName, std::wstring& value)
+{
+	HKEY hKey = NULL;
+	auto dwErr = static_cast<DWORD>(RegOpenKeyExW(HKEY_LOCAL_MACHINE, szKey, 0, KEY_READ, &hKey));
+	if (ERROR_SUCCESS != dwErr) return dwErr;
+
+	dwErr = RegQueryWszExpand(hKey, szValueName, value);
+	RegCloseKey(hKey);
+	return dwErr;
+} // QueryWin32Registry
 
-	if (dwErr == ERROR_SUCCESS)
+const MAPIRegistry mapiWin32Registry = { NULL, QueryWin32Registry };
+
+// A value of a snapshot, before expanding
+struct MAPIRegistryValue
+{
+	DWORD dwType;
+	std::wstring data;
+};
+
+// Key path and value name, both lower case, since the registry ignores case
+typedef std::pair<std::wstring, std::wstring> MAPIRegistryValueName;
+typedef std::map<MAPIRegistryValueName, MAPIRegistryValue> MAPIRegistryValues;
+
+static MAPIRegistryValueName GetMAPIRegistryValueName(_In_z_ LPCWSTR szKey, _In_opt_z_ LPCWSTR szValueName)
+{
+	MAPIRegistryValueName name(szKey, szValueName ? szValueName : L"");
+	std::transform(name.first.begin(), name.first.end(), name.first.begin(), towlower);
+	std::transform(name.second.begin(), name.second.end(), name.second.begin(), towlower);
+	return name;
+} // GetMAPIRegistryValueName
+
+// Replaced whole, never changed in place, so a reader holding one needs no lock
+static std::shared_ptr<const MAPIRegistryValues> g_lpMAPIRegistrySnapshot;
+
+static DWORD QueryMAPIRegistryValues(
+	const std::shared_ptr<const MAPIRegistryValues>& lpValues,
+	_In_z_ LPCWSTR szKey,
+	_In_opt_z_ LPCWSTR szValueName,
+	std::wstring& value)
+{
+	if (!lpValues) return ERROR_FILE_NOT_FOUND;
+
+	auto it = lpValues->find(GetMAPIRegistryValueName(szKey, szValueName));
+	if (lpValues->end() == it) return ERROR_FILE_NOT_FOUND;
+
+	value = it->second.data;
+	return ExpandRegString(it->second.dwType, value);
+} // QueryMAPIRegistryValues
+
+// Reads every string value under hKey, and under each of its subkeys, into values
+static void SnapshotRegistryKey(HKEY hKey, const std::wstring& keyPath, MAPIRegistryValues& values)
+{
+	DWORD cSubKeys = 0;
+	DWORD cchMaxSubKey = 0;
+	DWORD cValues = 0;
+	DWORD cchMaxValueName = 0;
+	DWORD cbMaxValue = 0;
+	if (ERROR_SUCCESS != RegQueryInfoKeyW(hKey, NULL, NULL, NULL, &cSubKeys, &cchMaxSubKey, NULL, &cValues, &cchMaxValueName, &cbMaxValue, NULL, NULL))
 	{
-		if (dwType == REG_EXPAND_SZ)
-		{
-			// Expand the strings
-			DWORD cch = ExpandEnvironmentStringsW(rgchValue, lpValue, cchValueLen);
-			if ((0 == cch) || (cch > cchValueLen))
-			{
-				dwErr = ERROR_INSUFFICIENT_BUFFER;
-				goto Exit;
-			}
-		}
-		else if (dwType == REG_SZ)
-		{
-			wcscpy_s(lpValue, cchValueLen, rgchValue);
-		}
+		return;
 	}
-Exit:
-	return dwErr;
-} // RegQueryWszExpand
+
+	std::vector<WCHAR> valueName(cchMaxValueName + 1);
+	std::vector<BYTE> data(cbMaxValue + sizeof(WCHAR));
+	for (DWORD i = 0; i < cValues; i++)
+	{
+		auto cchValueName = static_cast<DWORD>(valueName.size());
+		auto cbData = static_cast<DWORD>(data.size() - sizeof(WCHAR));
+		DWORD dwType = 0;
+		if (ERROR_SUCCESS != RegEnumValueW(hKey, i, valueName.data(), &cchValueName, NULL, &dwType, data.data(), &cbData)) continue;
+		if (REG_SZ != dwType && REG_EXPAND_SZ != dwType) continue;
+
+		MAPIRegistryValue value = { dwType, std::wstring(reinterpret_cast<LPCWSTR>(data.data()), cbData / sizeof(WCHAR)) };
+		value.data.resize(wcsnlen(value.data.c_str(), value.data.size()));
+		values[GetMAPIRegistryValueName(keyPath.c_str(), valueName.data())] = value;
+	}
+
+	std::vector<WCHAR> subKeyName(cchMaxSubKey + 1);
+	for (DWORD i = 0; i < cSubKeys; i++)
+	{
+		auto cchSubKeyName = static_cast<DWORD>(subKeyName.size());
+		if (ERROR_SUCCESS != RegEnumKeyExW(hKey, i, subKeyName.data(), &cchSubKeyName, NULL, NULL, NULL, NULL)) continue;
+
+		HKEY hSubKey = NULL;
+		if (ERROR_SUCCESS != RegOpenKeyExW(hKey, subKeyName.data(), 0, KEY_READ, &hSubKey)) continue;
+
+		SnapshotRegistryKey(hSubKey, keyPath + L"\\" + subKeyName.data(), values);
+		RegCloseKey(hSubKey);
+	}
+} // SnapshotRegistryKey
+
+static void RefreshMAPIRegistrySnapshot()
+{
+	auto lpValues = std::make_shared<MAPIRegistryValues>();
+
+	HKEY hMailKey = NULL;
+	if (ERROR_SUCCESS == RegOpenKeyExW(HKEY_LOCAL_MACHINE, WszKeyNameMailClient, 0, KEY_READ, &hMailKey))
+	{
+		SnapshotRegistryKey(hMailKey, WszKeyNameMailClient, *lpValues);
+		RegCloseKey(hMailKey);
+	}
+
+	std::atomic_store(&g_lpMAPIRegistrySnapshot, std::shared_ptr<const MAPIRegistryValues>(lpValues));
+} // RefreshMAPIRegistrySnapshot
+
+static DWORD QueryMAPIRegistrySnapshot(_In_z_ LPCWSTR szKey, _In_opt_z_ LPCWSTR szValueName, std::wstring& value)
+{
+	return QueryMAPIRegistryValues(std::atomic_load(&g_lpMAPIRegistrySnapshot), szKey, szValueName, value);
+} // QueryMAPIRegistrySnapshot
+
+const MAPIRegistry mapiSnapshotRegistry = { RefreshMAPIRegistrySnapshot, QueryMAPIRegistrySnapshot };
+
+static std::atomic<const MAPIRegistry*> g_lpMAPIRegistry(&mapiWin32Registry);
+
+static const MAPIRegistry* GetMAPIRegistry()
+{
+	return g_lpMAPIRegistry.load(std::memory_order_acquire);
+} // GetMAPIRegistry
+
+void SetMAPIRegistry(_In_opt_ const MAPIRegistry* lpRegistry)
+{
+	g_lpMAPIRegistry.store(lpRegistry ? lpRegistry : &mapiWin32Registry, std::memory_order_release);
+
+	// What was found under the last registry says nothing about this one
+	InvalidateMAPIDiscovery();
+} // SetMAPIRegistry
+
+/*
+ *  GetMAPIStubDll
+ *		mapi32.dll, or mapistub.dll, loaded once and pinned for FGetComponentPath
+ */
+static HMODULE GetMAPIStubDll()
+{
+	auto hinstStub = g_hinstMAPIStubDll.load(std::memory_order_acquire);
+	if (hinstStub) return hinstStub;
+
+	hinstStub = LoadLibraryW(WszMapi32);
+	if (!hinstStub)
+		hinstStub = LoadLibraryW(WszMapiStub);
+	if (!hinstStub) return NULL;
+
+	// Probes run on several threads. Whichever pins the DLL first wins and the rest drop their reference.
+	HMODULE hinstNULL = NULL;
+	if (!g_hinstMAPIStubDll.compare_exchange_strong(hinstNULL, hinstStub, std::memory_order_acq_rel))
+	{
+		FreeLibrary(hinstStub);
+		hinstStub = hinstNULL;
+	}
+
+	return hinstStub;
+} // GetMAPIStubDll
 
 /*
  *  GetComponentPath
@@ -182,29 +513,44 @@ Exit:
  */
 bool GetComponentPath(LPCSTR szComponent, LPSTR szQualifier, LPSTR szDllPath, DWORD cchBufferSize, bool fInstall)
 {
-	HMODULE hMapiStub = NULL;
-	bool fReturn = FALSE;
+	auto pFGetCompPath = g_lpfnFGetComponentPath.load(std::memory_order_acquire);
+	if (!pFGetCompPath)
+	{
+		auto hMapiStub = GetMAPIStubDll();
+		if (!hMapiStub) return false;
 
-	typedef bool (STDAPICALLTYPE *FGetComponentPathType)(LPCSTR, LPSTR, LPSTR, DWORD, bool);
+		pFGetCompPath = (FGetComponentPathType)GetProcAddress(hMapiStub, SzFGetComponentPath);
+		if (!pFGetCompPath) return false;
 
-	hMapiStub = LoadLibraryW(WszMapi32);
-	if (!hMapiStub)
-		hMapiStub = LoadLibraryW(WszMapiStub);
+		g_lpfnFGetComponentPath.store(pFGetCompPath, std::memory_order_release);
+	}
 
-	if (hMapiStub)
-	{
-		FGetComponentPathType pFGetCompPath = (FGetComponentPathType)GetProcAddress(hMapiStub, SzFGetComponentPath);
+	return pFGetCompPath(szComponent, szQualifier, szDllPath, cchBufferSize, fInstall);
+} // GetComponentPath
 
-		if (pFGetCompPath)
+/*
+ *  LoadMAPIPath
+ *		LoadLibraryW for a discovered MAPI path. When that path is the stub DLL discovery already
+ *		pinned, the loaded module just gets another reference rather than going back through the
+ *		loader's search.
+ */
+static HMODULE LoadMAPIPath(_In_z_ LPCWSTR szPath)
+{
+	auto hinstStub = g_hinstMAPIStubDll.load(std::memory_order_acquire);
+	if (hinstStub)
+	{
+		WCHAR szStubPath[MAX_PATH] = { 0 };
+		HMODULE hinstMAPI = NULL;
+		auto cchStubPath = GetModuleFileNameW(hinstStub, szStubPath, _countof(szStubPath));
+		if (cchStubPath && cchStubPath < _countof(szStubPath) && 0 == _wcsicmp(szStubPath, szPath) &&
+			GetModuleHandleExW(0UL, szStubPath, &hinstMAPI))
 		{
-			fReturn = pFGetCompPath(szComponent, szQualifier, szDllPath, cchBufferSize, fInstall);
+			return hinstMAPI;
 		}
-
-		FreeLibrary(hMapiStub);
 	}
 
-	return fReturn;
-} // GetComponentPath
+	return LoadLibraryW(szPath);
+} // LoadMAPIPath
 
 enum mapiSource
 {
@@ -234,18 +580,11 @@ MAPIPathIterator::MAPIPathIterator(bool bBypassRestrictions)
 		else
 			CurrentSource = msSystem;
 	}
-	m_hMailKey = NULL;
-	m_hkeyMapiClient = NULL;
-	m_rgchMailClient = NULL;
-
 	m_iCurrentOutlook = oqcOfficeBegin;
 }
 
 MAPIPathIterator::~MAPIPathIterator()
 {
-	delete[] m_rgchMailClient;
-	if (m_hMailKey) RegCloseKey(m_hMailKey);
-	if (m_hkeyMapiClient) RegCloseKey(m_hkeyMapiClient);
 }
 
 LPWSTR MAPIPathIterator::GetNextMAPIPath()
@@ -255,39 +594,52 @@ LPWSTR MAPIPathIterator::GetNextMAPIPath()
 	LPWSTR szPath = NULL;
 	while (msEnd != CurrentSource && !szPath)
 	{
-		switch (CurrentSource)
-		{
-		case msRegisteredMSI:
-			szPath = GetRegisteredMapiClient(WszOutlookMapiClientName, false, false);
-			CurrentSource = msRegisteredDLLEx;
-			break;
-		case msRegisteredDLLEx:
-			szPath = GetRegisteredMapiClient(WszOutlookMapiClientName, true, true);
-			CurrentSource = msRegisteredDLL;
-			break;
-		case msRegisteredDLL:
-			szPath = GetRegisteredMapiClient(WszOutlookMapiClientName, true, false);
-			if (s_fForceOutlookMAPI && !m_bBypassRestrictions)
-			{
-				CurrentSource = msEnd;
-			}
-			else
-			{
-				CurrentSource = msSystem;
-			}
-			break;
-		case msSystem:
-			szPath = GetMAPISystemDir();
-			CurrentSource = msEnd;
-			break;
-		case msEnd:
-		default:
-			break;
-		}
+		szPath = GetMAPIPath(CurrentSource);
+		CurrentSource = GetNextSource(CurrentSource);
 	}
 	return szPath;
 }
 
+mapiSource MAPIPathIterator::GetCurrentSource() const
+{
+	return CurrentSource;
+}
+
+mapiSource MAPIPathIterator::GetNextSource(mapiSource source) const
+{
+	switch (source)
+	{
+	case msRegisteredMSI:
+		return msRegisteredDLLEx;
+	case msRegisteredDLLEx:
+		return msRegisteredDLL;
+	case msRegisteredDLL:
+		return s_fForceOutlookMAPI && !m_bBypassRestrictions ? msEnd : msSystem;
+	case msSystem:
+	case msEnd:
+	default:
+		return msEnd;
+	}
+}
+
+LPWSTR MAPIPathIterator::GetMAPIPath(mapiSource source)
+{
+	switch (source)
+	{
+	case msRegisteredMSI:
+		return GetRegisteredMapiClient(WszOutlookMapiClientName, false, false);
+	case msRegisteredDLLEx:
+		return GetRegisteredMapiClient(WszOutlookMapiClientName, true, true);
+	case msRegisteredDLL:
+		return GetRegisteredMapiClient(WszOutlookMapiClientName, true, false);
+	case msSystem:
+		return GetMAPISystemDir();
+	case msEnd:
+	default:
+		return NULL;
+	}
+}
+
 // if cchszA == -1, MultiByteToWideChar will compute the length
 // Delete with delete[]
 _Check_return_ void AnsiToUnicode(_In_opt_z_ LPCSTR pszA, _Out_z_cap_(cchszA) LPWSTR* ppszW, size_t cchszA)
@@ -329,26 +681,39 @@ _Check_return_ void AnsiToUnicode(_In_opt_z_ LPCSTR pszA, _Out_z_cap_(cchszA) LP
 	}
 }
 
+// An empty string if szW can't be converted
+static std::string UnicodeToAnsi(_In_z_ LPCWSTR szW)
+{
+	auto cch = WideCharToMultiByte(CP_ACP, 0, szW, -1, NULL, 0, NULL, NULL);
+	if (cch <= 0) return std::string();
+
+	std::string str(cch, '\0');
+	if (!WideCharToMultiByte(CP_ACP, 0, szW, -1, &str[0], cch, NULL, NULL)) return std::string();
+
+	str.resize(cch - 1);
+	return str;
+} // UnicodeToAnsi
+
 /*
  *  GetMailClientFromMSIData
  *		Attempt to locate the MAPI provider DLL via HKLM\Software\Clients\Mail\(provider)\MSIComponentID
  */
-LPWSTR MAPIPathIterator::GetMailClientFromMSIData(HKEY hkeyMapiClient)
+LPWSTR MAPIPathIterator::GetMailClientFromMSIData(LPCWSTR szMapiClientKey)
 {
-	CHAR rgchMSIComponentID[MAX_PATH] = { 0 };
-	CHAR rgchMSIApplicationLCID[MAX_PATH] = { 0 };
 	CHAR rgchComponentPath[MAX_PATH] = { 0 };
-	DWORD dwType = 0;
 	LPWSTR szPath = NULL;
-	HRESULT hRes = S_OK;
-
-	DWORD dwSizeComponentID = sizeof(rgchMSIComponentID);
-	DWORD dwSizeLCID = sizeof(rgchMSIApplicationLCID);
+	auto lpRegistry = GetMAPIRegistry();
 
-	if (ERROR_SUCCESS == RegQueryValueExA(hkeyMapiClient, SzValueNameMSI, 0, &dwType, (LPBYTE)&rgchMSIComponentID, &dwSizeComponentID) &&
-		ERROR_SUCCESS == RegQueryValueExA(hkeyMapiClient, SzValueNameLCID, 0, &dwType, (LPBYTE)&rgchMSIApplicationLCID, &dwSizeLCID))
+	std::wstring componentID;
+	std::wstring applicationLCID;
+	if (ERROR_SUCCESS == lpRegistry->lpfnQueryString(szMapiClientKey, WszValueNameMSI, componentID) &&
+		ERROR_SUCCESS == lpRegistry->lpfnQueryString(szMapiClientKey, WszValueNameLCID, applicationLCID))
 	{
-		if (GetComponentPath(rgchMSIComponentID, rgchMSIApplicationLCID, rgchComponentPath, _countof(rgchComponentPath), FALSE))
+		// FGetComponentPath takes ANSI strings
+		auto szComponentID = UnicodeToAnsi(componentID.c_str());
+		auto szApplicationLCID = UnicodeToAnsi(applicationLCID.c_str());
+		if (!szComponentID.empty() &&
+			GetComponentPath(szComponentID.c_str(), &szApplicationLCID[0], rgchComponentPath, _countof(rgchComponentPath), FALSE))
 		{
 			AnsiToUnicode(rgchComponentPath, &szPath, -1);
 		}
@@ -361,30 +726,14 @@ LPWSTR MAPIPathIterator::GetMailClientFromMSIData(HKEY hkeyMapiClient)
  *  GetMailClientFromDllPath
  *		Attempt to locate the MAPI provider DLL via HKLM\Software\Clients\Mail\(provider)\DllPathEx
  */
-LPWSTR MAPIPathIterator::GetMailClientFromDllPath(HKEY hkeyMapiClient, bool bEx)
+LPWSTR MAPIPathIterator::GetMailClientFromDllPath(LPCWSTR szMapiClientKey, bool bEx)
 {
-	LPWSTR szPath = NULL;
-	DWORD ret = ERROR_SUCCESS;
-
-	szPath = new WCHAR[MAX_PATH];
-
-	if (szPath)
-	{
-		if (bEx)
-		{
-			ret = RegQueryWszExpand(hkeyMapiClient, WszValueNameDllPathEx, szPath, MAX_PATH);
-		}
-		else
-		{
-			ret = RegQueryWszExpand(hkeyMapiClient, WszValueNameDllPath, szPath, MAX_PATH);
-		}
-		if (ERROR_SUCCESS == ret)
-		{
-			delete[] szPath;
-			szPath = NULL;
-		}
-	}
+	std::wstring path;
+	auto ret = GetMAPIRegistry()->lpfnQueryString(szMapiClientKey, bEx ? WszValueNameDllPathEx : WszValueNameDllPath, path);
+	if (ERROR_SUCCESS != ret || path.empty()) return NULL;
 
+	auto szPath = new WCHAR[path.size() + 1];
+	wcscpy_s(szPath, path.size() + 1, path.c_str());
 	return szPath;
 } // MAPIPathIterator::GetMailClientFromDllPath
 
@@ -397,73 +746,31 @@ LPWSTR MAPIPathIterator::GetMailClientFromDllPath(HKEY hkeyMapiClient, bool bEx)
  */
 LPWSTR MAPIPathIterator::GetRegisteredMapiClient(LPCWSTR pwzProviderOverride, bool bDLL, bool bEx)
 {
-	DWORD ret = ERROR_SUCCESS;
 	LPWSTR szPath = NULL;
 	LPCWSTR pwzProvider = pwzProviderOverride;
 
-	if (!m_hMailKey)
-	{
-		// Open HKLM\Software\Clients\Mail
-		ret = RegOpenKeyExW(HKEY_LOCAL_MACHINE,
-			WszKeyNameMailClient,
-			0,
-			KEY_READ,
-			&m_hMailKey);
-		if (ERROR_SUCCESS == ret)
-		{
-			m_hMailKey = NULL;
-		}
-	}
-
 	// If a specific provider wasn't specified, load the name of the default MAPI provider
-	if (m_hMailKey && !pwzProvider && !m_rgchMailClient)
+	// from the default value of HKLM\Software\Clients\Mail
+	if (!pwzProvider && m_szMailClient.empty())
 	{
-		m_rgchMailClient = new WCHAR[MAX_PATH];
-		if (m_rgchMailClient)
+		if (ERROR_SUCCESS != GetMAPIRegistry()->lpfnQueryString(WszKeyNameMailClient, NULL, m_szMailClient))
 		{
-			// Get Outlook application path registry value
-			DWORD dwSize = MAX_PATH;
-			DWORD dwType = 0;
-			ret = RegQueryValueExW(
-				m_hMailKey,
-				NULL,
-				0,
-				&dwType,
-				(LPBYTE)m_rgchMailClient,
-				&dwSize);
-			if (ERROR_SUCCESS != ret)
-			{
-				delete[] m_rgchMailClient;
-				m_rgchMailClient = NULL;
-			}
+			m_szMailClient.clear();
 		}
 	}
 
-	if (!pwzProvider) pwzProvider = m_rgchMailClient;
-
-	if (m_hMailKey && pwzProvider && !m_hkeyMapiClient)
-	{
-		ret = RegOpenKeyExW(
-			m_hMailKey,
-			pwzProvider,
-			0,
-			KEY_READ,
-			&m_hkeyMapiClient);
-		if (ERROR_SUCCESS != ret)
-		{
-			m_hkeyMapiClient = NULL;
-		}
-	}
+	if (!pwzProvider && !m_szMailClient.empty()) pwzProvider = m_szMailClient.c_str();
 
-	if (m_hkeyMapiClient)
+	if (pwzProvider)
 	{
+		auto mapiClientKey = std::wstring(WszKeyNameMailClient) + L"\\" + pwzProvider;
 		if (bDLL)
 		{
-			szPath = GetMailClientFromDllPath(m_hkeyMapiClient, bEx);
+			szPath = GetMailClientFromDllPath(mapiClientKey.c_str(), bEx);
 		}
 		else
 		{
-			szPath = GetMailClientFromMSIData(m_hkeyMapiClient);
+			szPath = GetMailClientFromMSIData(mapiClientKey.c_str());
 		}
 	}
 
@@ -499,26 +806,225 @@ WCHAR g_pszOutlookQualifiedComponents[][MAX_PATH] = {
 	L"{BC174BAD-2F53-4855-A1D5-1D575C19B1EA}", // O11_CATEGORY_GUID_CORE_OFFICE (debug)  // STRING_OK
 };
 
+// File SetMAPIPathCache named, or empty if there's no cache
+static WCHAR g_szMAPIPathCache[MAX_PATH] = { 0 };
+
+void SetMAPIPathCache(_In_opt_z_ LPCWSTR szCacheFile)
+{
+	if (!szCacheFile || wcslen(szCacheFile) >= _countof(g_szMAPIPathCache))
+	{
+		g_szMAPIPathCache[0] = L'\0';
+		return;
+	}
+
+	wcscpy_s(g_szMAPIPathCache, _countof(g_szMAPIPathCache), szCacheFile);
+} // SetMAPIPathCache
+
+static void AppendRegValue(LPCWSTR szKey, LPCWSTR szValueName, std::wstring& fingerprint)
+{
+	std::wstring value;
+	if (ERROR_SUCCESS == GetMAPIRegistry()->lpfnQueryString(szKey, szValueName, value))
+	{
+		fingerprint += value;
+	}
+
+	fingerprint += L'\n';
+} // AppendRegValue
+
+/*
+ *  GetMAPIDiscoveryFingerprint
+ *		Everything discovery's result depends on besides the DLL itself: the options, the system
+ *		directory and the registered client's values. Reading them costs a few registry reads,
+ *		where discovery loads mapi32.dll and asks MSI for the path.
+ */
+static std::wstring GetMAPIDiscoveryFingerprint()
+{
+	std::wstring fingerprint;
+	fingerprint += s_fForceOutlookMAPI ? L'O' : L'-';
+	fingerprint += s_fForceSystemMAPI ? L'S' : L'-';
+	fingerprint += L'\n';
+
+	WCHAR szSystemDir[MAX_PATH] = { 0 };
+	GetSystemDirectoryW(szSystemDir, MAX_PATH);
+	fingerprint += szSystemDir;
+	fingerprint += L'\n';
+
+	std::wstring keyName = std::wstring(WszKeyNameMailClient) + L"\\" + WszOutlookMapiClientName;
+	AppendRegValue(keyName.c_str(), WszValueNameMSI, fingerprint);
+	AppendRegValue(keyName.c_str(), WszValueNameLCID, fingerprint);
+	AppendRegValue(keyName.c_str(), WszValueNameDllPathEx, fingerprint);
+	AppendRegValue(keyName.c_str(), WszValueNameDllPath, fingerprint);
+
+	return fingerprint;
+} // GetMAPIDiscoveryFingerprint
+
+static bool GetMAPIFileStamp(_In_z_ LPCWSTR szPath, _Out_ ULONGLONG* lpcbFile, _Out_ FILETIME* lpftLastWrite)
+{
+	*lpcbFile = 0;
+	*lpftLastWrite = {};
+
+	WIN32_FILE_ATTRIBUTE_DATA fileData = {};
+	if (!GetFileAttributesExW(szPath, GetFileExInfoStandard, &fileData)) return false;
+
+	*lpcbFile = (static_cast<ULONGLONG>(fileData.nFileSizeHigh) << 32) | fileData.nFileSizeLow;
+	*lpftLastWrite = fileData.ftLastWriteTime;
+	return true;
+} // GetMAPIFileStamp
+
+static bool ReadCacheString(FILE* cacheFile, std::wstring& str)
+{
+	ULONG cch = 0;
+	if (fread(&cch, sizeof(cch), 1, cacheFile) != 1 || cch > 0x10000) return false;
+
+	str.resize(cch);
+	return !cch || fread(&str[0], sizeof(WCHAR), cch, cacheFile) == cch;
+} // ReadCacheString
+
+static bool WriteCacheString(FILE* cacheFile, const std::wstring& str)
+{
+	auto cch = static_cast<ULONG>(str.size());
+	return fwrite(&cch, sizeof(cch), 1, cacheFile) == 1 &&
+		(!cch || fwrite(str.data(), sizeof(WCHAR), cch, cacheFile) == cch);
+} // WriteCacheString
+
+/*
+ *  LoadCachedMAPIPath
+ *		Loads the path in the cache if it was found from the same fingerprint, and the file there
+ *		has the same size and time as it did then. Anything else means discovery runs.
+ */
+static HMODULE LoadCachedMAPIPath(const std::wstring& fingerprint)
+{
+	FILE* cacheFile = NULL;
+	if (_wfopen_s(&cacheFile, g_szMAPIPathCache, L"rb") || !cacheFile) return NULL;
+
+	char rgchSignature[sizeof(rgchMAPIPathCacheSignature)] = { 0 };
+	std::wstring cachedFingerprint;
+	std::wstring path;
+	ULONGLONG cbCachedFile = 0;
+	FILETIME ftCachedLastWrite = {};
+	auto fRead = fread(rgchSignature, sizeof(rgchSignature), 1, cacheFile) == 1 &&
+		0 == memcmp(rgchSignature, rgchMAPIPathCacheSignature, sizeof(rgchSignature)) &&
+		ReadCacheString(cacheFile, cachedFingerprint) &&
+		ReadCacheString(cacheFile, path) &&
+		fread(&cbCachedFile, sizeof(cbCachedFile), 1, cacheFile) == 1 &&
+		fread(&ftCachedLastWrite, sizeof(ftCachedLastWrite), 1, cacheFile) == 1;
+	fclose(cacheFile);
+	if (!fRead || cachedFingerprint != fingerprint || path.empty()) return NULL;
+
+	ULONGLONG cbFile = 0;
+	FILETIME ftLastWrite = {};
+	if (!GetMAPIFileStamp(path.c_str(), &cbFile, &ftLastWrite) ||
+		cbFile != cbCachedFile ||
+		0 != CompareFileTime(&ftLastWrite, &ftCachedLastWrite))
+	{
+		return NULL;
+	}
+
+	return LoadMAPIPath(path.c_str());
+} // LoadCachedMAPIPath
+
+// Best effort. A cache that can't be written only means the next process searches again.
+static void WriteMAPIPathCache(const std::wstring& fingerprint, _In_z_ LPCWSTR szPath)
+{
+	ULONGLONG cbFile = 0;
+	FILETIME ftLastWrite = {};
+	if (!GetMAPIFileStamp(szPath, &cbFile, &ftLastWrite)) return;
+
+	FILE* cacheFile = NULL;
+	if (_wfopen_s(&cacheFile, g_szMAPIPathCache, L"wb") || !cacheFile) return;
+
+	auto fWritten = fwrite(rgchMAPIPathCacheSignature, sizeof(rgchMAPIPathCacheSignature), 1, cacheFile) == 1 &&
+		WriteCacheString(cacheFile, fingerprint) &&
+		WriteCacheString(cacheFile, szPath) &&
+		fwrite(&cbFile, sizeof(cbFile), 1, cacheFile) == 1 &&
+		fwrite(&ftLastWrite, sizeof(ftLastWrite), 1, cacheFile) == 1;
+	if (0 != fclose(cacheFile)) fWritten = false;
+
+	// A partial cache fails its next read anyway, but there's no reason to leave one around
+	if (!fWritten) _wremove(g_szMAPIPathCache);
+} // WriteMAPIPathCache
+
+// One source's candidate path, resolved on a thread of its own
+struct MAPIPathProbe
+{
+	mapiSource source;
+	LPWSTR szPath;
+	bool fFound;
+};
+
+static DWORD WINAPI ProbeMAPIPath(LPVOID lpParam)
+{
+	auto lpProbe = static_cast<MAPIPathProbe*>(lpParam);
+
+	// Each probe has its own iterator, since an iterator keeps the registry keys it opens
+	MAPIPathIterator mpi(false);
+	lpProbe->szPath = mpi.GetMAPIPath(lpProbe->source);
+
+	// A path to a file that isn't there needn't be loaded to know it fails. A bare name is left
+	// for LoadLibrary to search for.
+	auto dwAttributes = lpProbe->szPath ? GetFileAttributesW(lpProbe->szPath) : INVALID_FILE_ATTRIBUTES;
+	lpProbe->fFound = lpProbe->szPath &&
+		(!wcschr(lpProbe->szPath, L'\\') ||
+			(INVALID_FILE_ATTRIBUTES != dwAttributes && !(dwAttributes & FILE_ATTRIBUTE_DIRECTORY)));
+	return 0;
+} // ProbeMAPIPath
+
+/*
+ *  GetDefaultMapiHandle
+ *		Resolves every source at once, since any of them can block on the registry, MSI or a
+ *		slow disk, then loads the first that works in the order GetNextMAPIPath would have tried
+ *		them. Discovery takes as long as the slowest probe rather than all of them together.
+ */
 HMODULE GetDefaultMapiHandle()
 {
 	HMODULE hinstMapi = NULL;
 
-	LPWSTR szPath = NULL;
-	MAPIPathIterator* mpi = new MAPIPathIterator(false);
+	// Everything below reads the registry through this, the fingerprint included
+	auto lpRegistry = GetMAPIRegistry();
+	if (lpRegistry->lpfnRefresh) lpRegistry->lpfnRefresh();
 
-	if (mpi)
+	std::wstring fingerprint;
+	auto fCache = 0 != g_szMAPIPathCache[0];
+	if (fCache)
 	{
-		while (!hinstMapi)
-		{
-			szPath = mpi->GetNextMAPIPath();
-			if (!szPath) break;
+		fingerprint = GetMAPIDiscoveryFingerprint();
+		hinstMapi = LoadCachedMAPIPath(fingerprint);
+		if (hinstMapi) return hinstMapi;
+	}
+
+	MAPIPathProbe rgProbes[msEnd] = {};
+	HANDLE rghProbeThreads[msEnd] = {};
+	ULONG cProbes = 0;
+	MAPIPathIterator mpi(false);
+	for (auto source = mpi.GetCurrentSource(); msEnd != source && cProbes < msEnd; source = mpi.GetNextSource(source))
+	{
+		rgProbes[cProbes].source = source;
+		rghProbeThreads[cProbes] = CreateThread(NULL, 0, ProbeMAPIPath, &rgProbes[cProbes], 0, NULL);
+
+		// Without a thread the probe runs here, as it always used to
+		if (!rghProbeThreads[cProbes]) ProbeMAPIPath(&rgProbes[cProbes]);
+		cProbes++;
+	}
 
-			hinstMapi = LoadLibraryW(szPath);
-			delete[] szPath;
+	for (ULONG i = 0; i < cProbes; i++)
+	{
+		if (!rghProbeThreads[i]) continue;
+
+		WaitForSingleObject(rghProbeThreads[i], INFINITE);
+		CloseHandle(rghProbeThreads[i]);
+	}
+
+	for (ULONG i = 0; i < cProbes; i++)
+	{
+		if (!hinstMapi && rgProbes[i].fFound)
+		{
+			hinstMapi = LoadMAPIPath(rgProbes[i].szPath);
+			if (hinstMapi && fCache) WriteMAPIPathCache(fingerprint, rgProbes[i].szPath);
 		}
+
+		delete[] rgProbes[i].szPath;
 	}
 
-	delete mpi;
 	return hinstMapi;
 } // GetDefaultMapiHandle
 
@@ -541,52 +1047,161 @@ void UnLoadPrivateMAPI()
 	if (NULL != hinstPrivateMAPI)
 	{
 		SetMAPIHandle(NULL);
+
+		AcquireSRWLockExclusive(&g_srwMAPIDiscovery);
+		if (mdsBound == g_mapiDiscoveryState) g_mapiDiscoveryState = mdsUnbound;
+		ReleaseSRWLockExclusive(&g_srwMAPIDiscovery);
 	}
 } // UnLoadPrivateMAPI
 
 void ForceOutlookMAPI(bool fForce)
 {
 	s_fForceOutlookMAPI = fForce;
+	InvalidateMAPIDiscovery();
 } // ForceOutlookMAPI
 
 void ForceSystemMAPI(bool fForce)
 {
 	s_fForceSystemMAPI = fForce;
+	InvalidateMAPIDiscovery();
 } // ForceSystemMAPI
 
-HMODULE GetPrivateMAPI()
+void SetMAPIDiscoveryBackoff(ULONG ulMilliseconds)
 {
-	HMODULE hinstPrivateMAPI = GetMAPIHandle();
+	g_ulMAPIDiscoveryBackoff.store(ulMilliseconds, std::memory_order_relaxed);
+	InvalidateMAPIDiscovery();
+} // SetMAPIDiscoveryBackoff
+
+void InvalidateMAPIDiscovery()
+{
+	g_cMAPIDiscoveryFailures.store(0, std::memory_order_relaxed);
+	g_ullMAPIDiscoveryRetry.store(0, std::memory_order_release);
+} // InvalidateMAPIDiscovery
+
+static bool IsMAPIDiscoveryBackedOff()
+{
+	auto ullRetry = g_ullMAPIDiscoveryRetry.load(std::memory_order_acquire);
+	return 0 != ullRetry && GetTickCount64() < ullRetry;
+} // IsMAPIDiscoveryBackedOff
+
+static void RecordMAPIDiscoveryFailure()
+{
+	auto ulShift = g_cMAPIDiscoveryFailures.fetch_add(1, std::memory_order_relaxed);
+	if (ulShift > ulMaxMAPIDiscoveryBackoffShift) ulShift = ulMaxMAPIDiscoveryBackoffShift;
+
+	// A backoff of 0 turns the cache off
+	auto ullBackoff = static_cast<ULONGLONG>(g_ulMAPIDiscoveryBackoff.load(std::memory_order_relaxed)) << ulShift;
+	g_ullMAPIDiscoveryRetry.store(ullBackoff ? GetTickCount64() + ullBackoff : 0, std::memory_order_release);
+} // RecordMAPIDiscoveryFailure
+
+static HMODULE LoadDiscoveredMAPI()
+{
+	// First, try to attach to olmapi32.dll if it's loaded in the process
+	HMODULE hinstPrivateMAPI = AttachToMAPIDll(WszOlMAPI32DLL);
 
+	// If that fails try msmapi32.dll, for Outlook 11 and below
+	//  Only try this in the static lib, otherwise msmapi32.dll will attach to itself.
 	if (NULL == hinstPrivateMAPI)
 	{
-		// First, try to attach to olmapi32.dll if it's loaded in the process
-		hinstPrivateMAPI = AttachToMAPIDll(WszOlMAPI32DLL);
+		hinstPrivateMAPI = AttachToMAPIDll(WszMSMAPI32DLL);
+	}
 
-		// If that fails try msmapi32.dll, for Outlook 11 and below
-		//  Only try this in the static lib, otherwise msmapi32.dll will attach to itself.
-		if (NULL == hinstPrivateMAPI)
-		{
-			hinstPrivateMAPI = AttachToMAPIDll(WszMSMAPI32DLL);
-		}
+	// If MAPI isn't loaded in the process yet, then find the path to the DLL and
+	// load it manually.
+	if (NULL == hinstPrivateMAPI)
+	{
+		hinstPrivateMAPI = GetDefaultMapiHandle();
+	}
 
-		// If MAPI isn't loaded in the process yet, then find the path to the DLL and
-		// load it manually.
-		if (NULL == hinstPrivateMAPI)
-		{
-			hinstPrivateMAPI = GetDefaultMapiHandle();
-		}
+	return hinstPrivateMAPI;
+} // LoadDiscoveredMAPI
 
-		if (NULL != hinstPrivateMAPI)
-		{
-			SetMAPIHandle(hinstPrivateMAPI);
-		}
+static FARPROC GetDLLProcAddress(HMODULE hinstMAPI, _In_ LPCSTR lpszProcName)
+{
+	return ::GetProcAddress(hinstMAPI, lpszProcName);
+} // GetDLLProcAddress
+
+static void FreeDLL(HMODULE hinstMAPI)
+{
+	FreeLibrary(hinstMAPI);
+} // FreeDLL
+
+const MAPIBackend mapiDiscoveryBackend = { LoadDiscoveredMAPI, GetDLLProcAddress, FreeDLL };
+
+// Path mapiLibraryBackend loads, set by SetMAPILibraryPath
+static CHAR g_szMAPILibraryPath[MAX_PATH] = { 0 };
+
+bool SetMAPILibraryPath(_In_z_ LPCSTR szPath)
+{
+	if (strlen(szPath) >= _countof(g_szMAPILibraryPath)) return false;
+
+	strcpy_s(g_szMAPILibraryPath, _countof(g_szMAPILibraryPath), szPath);
+	InvalidateMAPIDiscovery();
+	return true;
+} // SetMAPILibraryPath
+
+static HMODULE LoadMAPILibrary()
+{
+	return g_szMAPILibraryPath[0] ? LoadLibraryA(g_szMAPILibraryPath) : NULL;
+} // LoadMAPILibrary
+
+const MAPIBackend mapiLibraryBackend = { LoadMAPILibrary, GetDLLProcAddress, FreeDLL };
+
+void SetMAPIBackend(_In_opt_ const MAPIBackend* lpBackend)
+{
+	// A loaded MAPI is freed by the backend that loaded it
+	UnLoadPrivateMAPI();
+	g_lpMAPIBackend.store(lpBackend ? lpBackend : &mapiDiscoveryBackend, std::memory_order_release);
+	InvalidateMAPIDiscovery();
+} // SetMAPIBackend
+
+HMODULE GetPrivateMAPI()
+{
+	HMODULE hinstPrivateMAPI = GetMAPIHandle();
+	if (NULL != hinstPrivateMAPI) return hinstPrivateMAPI;
+
+	// Only one thread discovers at a time. The rest wait for its result rather than
+	// repeating the search and loading their own copy of the DLL.
+	AcquireSRWLockExclusive(&g_srwMAPIDiscovery);
+	auto fWaited = false;
+	while (mdsBinding == g_mapiDiscoveryState)
+	{
+		fWaited = true;
+		SleepConditionVariableSRW(&g_cvMAPIDiscovery, &g_srwMAPIDiscovery, INFINITE, 0);
+	}
+
+	// Don't repeat a discovery that failed recently, or that we just waited on
+	hinstPrivateMAPI = GetMAPIHandle();
+	if (NULL != hinstPrivateMAPI ||
+		(mdsFailed == g_mapiDiscoveryState && (fWaited || IsMAPIDiscoveryBackedOff())))
+	{
+		ReleaseSRWLockExclusive(&g_srwMAPIDiscovery);
+		return hinstPrivateMAPI;
+	}
 
-		// Reason - if for any reason there is an instance already loaded, SetMAPIHandle()
-		// will free the new one and reuse the old one
-		// So we fetch the instance from the global again
-		return GetMAPIHandle();
+	g_mapiDiscoveryState = mdsBinding;
+	ReleaseSRWLockExclusive(&g_srwMAPIDiscovery);
+
+	hinstPrivateMAPI = GetMAPIBackend()->lpfnLoad();
+	if (NULL != hinstPrivateMAPI)
+	{
+		SetMAPIHandle(hinstPrivateMAPI);
+		InvalidateMAPIDiscovery();
 	}
+	else
+	{
+		RecordMAPIDiscoveryFailure();
+	}
+
+	// Reason - if for any reason there is an instance already loaded, SetMAPIHandle()
+	// will free the new one and reuse the old one
+	// So we fetch the instance from the global again
+	hinstPrivateMAPI = GetMAPIHandle();
+
+	AcquireSRWLockExclusive(&g_srwMAPIDiscovery);
+	g_mapiDiscoveryState = NULL != hinstPrivateMAPI ? mdsBound : mdsFailed;
+	ReleaseSRWLockExclusive(&g_srwMAPIDiscovery);
+	WakeAllConditionVariable(&g_cvMAPIDiscovery);
 
 	return hinstPrivateMAPI;
 } // GetPrivateMAPI
\ No newline at end of file
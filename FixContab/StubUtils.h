@@ -0,0 +1,101 @@
+#pragma once
+#include <windows.h>
+#include <stdio.h>
+#include <string>
+
+// Public entry points of the MAPI stub library. See StubUtils.cpp.
+
+HMODULE GetPrivateMAPI();
+HMODULE GetMAPIHandle();
+void UnLoadPrivateMAPI();
+void ForceOutlookMAPI(bool fForce);
+void ForceSystemMAPI(bool fForce);
+
+// After GetPrivateMAPI fails to find MAPI, it returns NULL without looking again until the
+// backoff has passed. The backoff doubles with each failure in a row. 0 always looks again.
+void SetMAPIDiscoveryBackoff(ULONG ulMilliseconds);
+
+// Forgets failed discoveries, such as after MAPI has been installed, so the next call looks again
+void InvalidateMAPIDiscovery();
+
+// Keeps the path discovery settles on in szCacheFile, so later processes can load it without
+// searching while the registry and the DLL are unchanged. NULL, the default, turns the cache off.
+void SetMAPIPathCache(_In_opt_z_ LPCWSTR szCacheFile);
+
+// An export of an in-process MAPI implementation
+struct MAPIExport
+{
+	LPCSTR szName; // Undecorated name, such as "MAPIInitialize"
+	FARPROC lpfn;
+};
+
+// Binds the stubs to an in-process export table instead of a MAPI DLL.
+// Pass NULL to go back to loading MAPI from disk.
+// The table must stay valid until it is unbound.
+void SetMAPIExports(_In_reads_opt_(cExports) const MAPIExport* lpExports, ULONG cExports);
+
+// How MAPI is loaded when no export table is bound
+struct MAPIBackend
+{
+	// Finds and loads MAPI. Returns NULL if it can't.
+	HMODULE (*lpfnLoad)();
+
+	// Looks up an export by name or, where the backend supports it, ordinal
+	FARPROC (*lpfnGetProcAddress)(HMODULE hinstMAPI, _In_ LPCSTR lpszProcName);
+
+	// Frees what lpfnLoad returned
+	void (*lpfnFree)(HMODULE hinstMAPI);
+};
+
+// Searches for Outlook's or the system's MAPI DLL, honoring ForceOutlookMAPI and ForceSystemMAPI.
+// The default.
+extern const MAPIBackend mapiDiscoveryBackend;
+
+// Loads the DLL named by SetMAPILibraryPath, such as a stand in for MAPI built for testing
+extern const MAPIBackend mapiLibraryBackend;
+
+bool SetMAPILibraryPath(_In_z_ LPCSTR szPath);
+
+// Chooses the backend, unloading any MAPI the previous one loaded. Pass NULL for the default.
+// Meant to be called once at startup, before any MAPI call.
+void SetMAPIBackend(_In_opt_ const MAPIBackend* lpBackend);
+
+// Where discovery reads the mail client registration under HKEY_LOCAL_MACHINE from
+struct MAPIRegistry
+{
+	// Called as each discovery starts, before any value is read. NULL if there's nothing to do.
+	void (*lpfnRefresh)();
+
+	// Reads a string value of HKEY_LOCAL_MACHINE\szKey, expanding REG_EXPAND_SZ. A NULL
+	// szValueName reads the key's default value. Returns a Win32 error code.
+	DWORD (*lpfnQueryString)(_In_z_ LPCWSTR szKey, _In_opt_z_ LPCWSTR szValueName, std::wstring& value);
+};
+
+// Reads each value from the registry as it's asked for. The default.
+extern const MAPIRegistry mapiWin32Registry;
+
+// Reads the whole Software\Clients\Mail subtree in one pass as each discovery starts, and
+// answers every read from that
+extern const MAPIRegistry mapiSnapshotRegistry;
+
+// Chooses where discovery reads the registry from. Pass NULL for the default.
+void SetMAPIRegistry(_In_opt_ const MAPIRegistry* lpRegistry);
+
+// Resolves a MAPI function against the bound export table, or the MAPI DLL
+FARPROC GetMAPIProcAddress(_In_ LPCSTR lpszProcName);
+
+// Resolves a MAPI function against the bound export table, or hinstMAPI if there is none.
+// Never loads MAPI, so it is safe to call while the binding is changing.
+FARPROC ResolveMAPIExport(HMODULE hinstMAPI, _In_ LPCSTR lpszProcName);
+
+// True if the stubs have an export table or a MAPI DLL to call into
+bool IsMAPIBound();
+
+// Resolves every stub against the bound export table or MAPI DLL, in one pass, and publishes
+// the result for every thread at once. Called whenever the binding changes. Returns how many
+// of the exports were found.
+ULONG BindMAPIStubs();
+
+// Writes each stub's call count, errors and latency histogram, busiest first. Only builds with
+// MAPISTUB_INSTRUMENT defined record them.
+void ReportMAPIStubStats(_In_ FILE* file);